@@ -0,0 +1,87 @@
+/**************************************************************************
+ *   bench.h  --  This file is part of Quadtree.                          *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+/**
+ * @brief       payload type used by the benchmarks
+ */
+class BenchPoint {
+public:
+    double x;
+    double y;
+
+    BenchPoint(double _x, double _y) : x(_x), y(_y) {}
+};
+
+/**
+ * @brief       simple wall clock timer
+ */
+class BenchTimer {
+private:
+    std::chrono::high_resolution_clock::time_point start;
+
+public:
+    BenchTimer() : start(std::chrono::high_resolution_clock::now()) {}
+
+    /**
+     * @brief       elapsed time in seconds since construction
+     */
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - this->start).count();
+    }
+};
+
+/**
+ * @brief       generate points uniformly distributed in the unit square
+ */
+inline std::vector<BenchPoint> bench_uniform_points(size_t n, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<BenchPoint> points;
+    points.reserve(n);
+    for(size_t i=0; i<n; i++) {
+        const double x = dist(rng);
+        const double y = dist(rng);
+        points.push_back(BenchPoint(x, y));
+    }
+    return points;
+}
+
+int bench_knn(int argc, char* argv[]);
+int bench_linear(int argc, char* argv[]);
+int bench_capacity(int argc, char* argv[]);
+int bench_concurrent(int argc, char* argv[]);
+int bench_file(int argc, char* argv[]);
+int bench_loose(int argc, char* argv[]);
+int bench_ray(int argc, char* argv[]);
+int bench_batch(int argc, char* argv[]);
+int bench_build(int argc, char* argv[]);
+int bench_pairs(int argc, char* argv[]);
+int bench_join(int argc, char* argv[]);
+int bench_count(int argc, char* argv[]);
+int bench_suite(int argc, char* argv[]);
+
+#endif //_BENCH_H
@@ -0,0 +1,164 @@
+/**************************************************************************
+ *   bench_batch.cpp  --  This file is part of Quadtree.                  *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+typedef QuadTree<BenchPoint> BatchTree;
+
+/**
+ * @brief       count the queries whose batch results differ from those of the individual queries
+ *
+ * @param       serial      results of the individual queries
+ * @param       batch       results of the batch
+ * @param       ordered     whether the order of the results matters (nearest first)
+ */
+static size_t bench_batch_mismatches(const std::vector<std::vector<BatchTree::Object>>& serial, const BatchTree::BatchResults& batch, bool ordered) {
+    size_t nr_mismatches = 0;
+    std::vector<const BenchPoint*> a;
+    std::vector<const BenchPoint*> b;
+    for(size_t i=0; i<serial.size(); i++) {
+        a.clear();
+        b.clear();
+        for(const auto& obj: serial[i]) {
+            a.push_back(obj.objptr);
+        }
+        for(const BatchTree::Object* obj = batch.begin(i); obj != batch.end(i); ++obj) {
+            b.push_back(obj->objptr);
+        }
+        if(!ordered) {
+            std::sort(a.begin(), a.end());
+            std::sort(b.begin(), b.end());
+        }
+        nr_mismatches += a != b;
+    }
+    return nr_mismatches;
+}
+
+/**
+ * @brief       print one row of the batch benchmark
+ */
+static void bench_batch_row(const std::string& query, const std::string& mode, double t, size_t nr_found, size_t nr_mismatches) {
+    std::cout << std::setw(8) << query
+              << std::setw(12) << mode
+              << std::setw(14) << std::fixed << std::setprecision(0) << t * 1e9
+              << std::setw(14) << nr_found
+              << std::setw(12) << nr_mismatches << std::endl;
+}
+
+/**
+ * @brief       compare batched range and kNN queries with the same queries issued one by one
+ *
+ * The queries are given in random order, such that the batch has to sort
+ * them to gain locality. The batches run on one thread and on all hardware
+ * threads; their results must equal those of the individual queries.
+ *
+ * usage: batch [points=1000000] [queries=100000] [extent=0.01] [k=8]
+ */
+int bench_batch(int argc, char* argv[]) {
+    const size_t nr_points = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const size_t nr_queries = argc > 2 ? std::atol(argv[2]) : 100000;
+    const double extent = argc > 3 ? std::atof(argv[3]) : 0.01;
+    const unsigned int k = argc > 4 ? std::atoi(argv[4]) : 8;
+    const unsigned int nr_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_points, 42);
+    std::vector<BatchTree::Object> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(BatchTree::Object(&p, p.x, p.y));
+    }
+    BatchTree tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+
+    const std::vector<BenchPoint> positions = bench_uniform_points(nr_queries, 1);
+    std::vector<BatchTree::RangeQuery> range_queries;
+    std::vector<BatchTree::KnnQuery> knn_queries;
+    for(const auto& q: positions) {
+        range_queries.push_back(BatchTree::RangeQuery(q.x, q.y, q.x + extent, q.y + extent));
+        knn_queries.push_back(BatchTree::KnnQuery(q.x, q.y, k));
+    }
+
+    std::cout << std::setw(8) << "query"
+              << std::setw(12) << "mode"
+              << std::setw(14) << "time (ns/q)"
+              << std::setw(14) << "found"
+              << std::setw(12) << "mismatches" << std::endl;
+
+    // individual queries, keeping their results for the comparison
+    std::vector<std::vector<BatchTree::Object>> serial(nr_queries);
+    size_t nr_found = 0;
+    BenchTimer range_timer;
+    for(size_t i=0; i<nr_queries; i++) {
+        const BatchTree::RangeQuery& q = range_queries[i];
+        tree.query_range(q.xmin, q.ymin, q.xmax, q.ymax, serial[i]);
+        nr_found += serial[i].size();
+    }
+    bench_batch_row("range", "serial", range_timer.elapsed() / nr_queries, nr_found, 0);
+
+    // the results are compared after the timers stopped
+    BatchTree::BatchResults results;
+    size_t nr_mismatches = 0;
+    BenchTimer range_batch_timer;
+    tree.query_range_batch(range_queries.data(), nr_queries, results, 1);
+    double t = range_batch_timer.elapsed() / nr_queries;
+    size_t nr_batch_mismatches = bench_batch_mismatches(serial, results, false);
+    bench_batch_row("range", "batch", t, results.objects.size(), nr_batch_mismatches);
+    nr_mismatches += nr_batch_mismatches;
+
+    BenchTimer range_parallel_timer;
+    tree.query_range_batch(range_queries.data(), nr_queries, results, nr_threads);
+    t = range_parallel_timer.elapsed() / nr_queries;
+    nr_batch_mismatches = bench_batch_mismatches(serial, results, false);
+    bench_batch_row("range", "parallel", t, results.objects.size(), nr_batch_mismatches);
+    nr_mismatches += nr_batch_mismatches;
+
+    nr_found = 0;
+    BatchTree::KnnScratch scratch;
+    BenchTimer knn_timer;
+    for(size_t i=0; i<nr_queries; i++) {
+        const BatchTree::KnnQuery& q = knn_queries[i];
+        tree.query_knn(q.x, q.y, q.k, serial[i], scratch);
+        nr_found += serial[i].size();
+    }
+    bench_batch_row("knn", "serial", knn_timer.elapsed() / nr_queries, nr_found, 0);
+
+    BenchTimer knn_batch_timer;
+    tree.query_knn_batch(knn_queries.data(), nr_queries, results, 1);
+    t = knn_batch_timer.elapsed() / nr_queries;
+    nr_batch_mismatches = bench_batch_mismatches(serial, results, true);
+    bench_batch_row("knn", "batch", t, results.objects.size(), nr_batch_mismatches);
+    nr_mismatches += nr_batch_mismatches;
+
+    BenchTimer knn_parallel_timer;
+    tree.query_knn_batch(knn_queries.data(), nr_queries, results, nr_threads);
+    t = knn_parallel_timer.elapsed() / nr_queries;
+    nr_batch_mismatches = bench_batch_mismatches(serial, results, true);
+    bench_batch_row("knn", "parallel", t, results.objects.size(), nr_batch_mismatches);
+    nr_mismatches += nr_batch_mismatches;
+
+    return nr_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/**************************************************************************
+ *   bench_build.cpp  --  This file is part of Quadtree.                  *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+typedef QuadTree<BenchPoint> BuildTree;
+
+/**
+ * @brief       check that two trees have the same nodes and hold the same objects in every leaf
+ *
+ * @return      number of nodes that differ
+ */
+static size_t bench_build_mismatches(const BuildTree& a, const BuildTree& b) {
+    typedef BuildTree::Node Node;
+
+    // both trees are traversed in the same order, such that nodes pair up
+    std::vector<const Node*> nodes_a;
+    std::vector<const Node*> nodes_b;
+    QuadTreeTraversal<const Node>::pre_order(a.get_root(), [&nodes_a](const Node* node) {
+        nodes_a.push_back(node);
+    });
+    QuadTreeTraversal<const Node>::pre_order(b.get_root(), [&nodes_b](const Node* node) {
+        nodes_b.push_back(node);
+    });
+    if(nodes_a.size() != nodes_b.size()) {
+        return std::max(nodes_a.size(), nodes_b.size()) - std::min(nodes_a.size(), nodes_b.size());
+    }
+
+    size_t nr_mismatches = 0;
+    std::vector<const BenchPoint*> objs_a;
+    std::vector<const BenchPoint*> objs_b;
+    for(size_t i=0; i<nodes_a.size(); i++) {
+        const Node* na = nodes_a[i];
+        const Node* nb = nodes_b[i];
+        if(na->has_children() != nb->has_children() || na->get_level() != nb->get_level() || na->get_count() != nb->get_count()) {
+            nr_mismatches++;
+            continue;
+        }
+        if(na->has_children()) {
+            continue;
+        }
+
+        objs_a.clear();
+        objs_b.clear();
+        for(const Node* chain = na; chain != nullptr; chain = chain->get_overflow()) {
+            for(unsigned int j=0; j<chain->get_nr_objects(); j++) {
+                objs_a.push_back(chain->get_object(j).objptr);
+            }
+        }
+        for(const Node* chain = nb; chain != nullptr; chain = chain->get_overflow()) {
+            for(unsigned int j=0; j<chain->get_nr_objects(); j++) {
+                objs_b.push_back(chain->get_object(j).objptr);
+            }
+        }
+        std::sort(objs_a.begin(), objs_a.end());
+        std::sort(objs_b.begin(), objs_b.end());
+        nr_mismatches += objs_a != objs_b;
+    }
+
+    return nr_mismatches;
+}
+
+/**
+ * @brief       compare the parallel bulk load with the serial bulk load and with one-by-one insertion
+ *
+ * All three trees must have the same structure and hold the same objects
+ * in every leaf. At most two trees are kept at a time.
+ *
+ * usage: build [max_exponent=6] [threads=0]
+ */
+int bench_build(int argc, char* argv[]) {
+    const unsigned int max_exp = argc > 1 ? std::atoi(argv[1]) : 6;
+    unsigned int nr_threads = argc > 2 ? std::atoi(argv[2]) : 0;
+    if(nr_threads == 0) {
+        nr_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::cout << std::setw(10) << "points"
+              << std::setw(10) << "threads"
+              << std::setw(12) << "add (s)"
+              << std::setw(12) << "bulk (s)"
+              << std::setw(14) << "parallel (s)"
+              << std::setw(10) << "speedup"
+              << std::setw(12) << "mismatches" << std::endl;
+
+    size_t nr_mismatches = 0;
+    for(unsigned int e=3; e<=max_exp; e++) {
+        size_t n = 1;
+        for(unsigned int i=0; i<e; i++) {
+            n *= 10;
+        }
+
+        std::vector<BenchPoint> points = bench_uniform_points(n, 42);
+        std::vector<BuildTree::Object> objs;
+        objs.reserve(points.size());
+        for(auto& p: points) {
+            objs.push_back(BuildTree::Object(&p, p.x, p.y));
+        }
+
+        BuildTree parallel(0.5, 0.5, 1.0, 1.0);
+        BenchTimer parallel_timer;
+        parallel.bulk_load_parallel(objs.data(), objs.size(), nr_threads);
+        const double t_parallel = parallel_timer.elapsed();
+
+        double t_bulk = 0.0;
+        size_t nr_differ = 0;
+        {
+            BuildTree bulk(0.5, 0.5, 1.0, 1.0);
+            BenchTimer bulk_timer;
+            bulk.bulk_load(objs.data(), objs.size());
+            t_bulk = bulk_timer.elapsed();
+            nr_differ += bench_build_mismatches(bulk, parallel);
+        }
+
+        double t_add = 0.0;
+        {
+            BuildTree added(0.5, 0.5, 1.0, 1.0);
+            BenchTimer add_timer;
+            for(const auto& obj: objs) {
+                added.add(obj.objptr, obj.x, obj.y);
+            }
+            t_add = add_timer.elapsed();
+            nr_differ += bench_build_mismatches(added, parallel);
+        }
+        nr_mismatches += nr_differ;
+
+        std::cout << std::setw(10) << n
+                  << std::setw(10) << nr_threads
+                  << std::setw(12) << std::fixed << std::setprecision(3) << t_add
+                  << std::setw(12) << t_bulk
+                  << std::setw(14) << t_parallel
+                  << std::setw(10) << std::setprecision(2) << (t_parallel > 0 ? t_bulk / t_parallel : 0.0)
+                  << std::setw(12) << nr_differ << std::endl;
+    }
+
+    return nr_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/**************************************************************************
+ *   bench_capacity.cpp  --  This file is part of Quadtree.               *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+/**
+ * @brief       measure build and query times of a quadtree with a given leaf capacity and coordinate type
+ */
+template <unsigned int Capacity, class Coord>
+static void bench_configuration(const std::string& coord_name, std::vector<BenchPoint>& points, const std::vector<BenchPoint>& queries, double extent) {
+    typedef QuadTree<BenchPoint, Capacity, Coord> Tree;
+
+    std::vector<typename Tree::Object> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(typename Tree::Object(&p, Coord(p.x), Coord(p.y)));
+    }
+
+    BenchTimer build_timer;
+    Tree tree(Coord(0.5), Coord(0.5), Coord(1), Coord(1), objs.data(), objs.size());
+    const double t_build = build_timer.elapsed();
+
+    std::vector<typename Tree::Object> results;
+    size_t nr_found = 0;
+    BenchTimer range_timer;
+    for(const auto& q: queries) {
+        results.clear();
+        tree.query_range(Coord(q.x), Coord(q.y), Coord(q.x + extent), Coord(q.y + extent), results);
+        nr_found += results.size();
+    }
+    const double t_range = range_timer.elapsed() / queries.size();
+
+    BenchTimer radius_timer;
+    for(const auto& q: queries) {
+        results.clear();
+        tree.query_radius(Coord(q.x), Coord(q.y), Coord(extent), results);
+        nr_found += results.size();
+    }
+    const double t_radius = radius_timer.elapsed() / queries.size();
+
+    BenchTimer knn_timer;
+    for(const auto& q: queries) {
+        tree.query_knn(Coord(q.x), Coord(q.y), 8, results);
+        nr_found += results.size();
+    }
+    const double t_knn = knn_timer.elapsed() / queries.size();
+
+    std::cout << std::setw(10) << points.size()
+              << std::setw(10) << Capacity
+              << std::setw(8) << coord_name
+              << std::setw(12) << std::fixed << std::setprecision(3) << t_build
+              << std::setw(14) << std::setprecision(0) << t_range * 1e9
+              << std::setw(14) << t_radius * 1e9
+              << std::setw(14) << t_knn * 1e9
+              << std::setw(14) << std::setprecision(1) << tree.get_memory_usage() / (1024.0 * 1024.0)
+              << std::setw(10) << sizeof(typename Tree::Node)
+              << std::setw(12) << std::setprecision(1) << 100.0 * points.size() / (double(tree.get_nr_nodes()) * Capacity)
+              << std::setw(12) << nr_found << std::endl;
+}
+
+template <class Coord>
+static void bench_capacities(const std::string& coord_name, std::vector<BenchPoint>& points, const std::vector<BenchPoint>& queries, double extent) {
+    bench_configuration<4, Coord>(coord_name, points, queries, extent);
+    bench_configuration<8, Coord>(coord_name, points, queries, extent);
+    bench_configuration<16, Coord>(coord_name, points, queries, extent);
+    bench_configuration<32, Coord>(coord_name, points, queries, extent);
+    bench_configuration<64, Coord>(coord_name, points, queries, extent);
+}
+
+/**
+ * @brief       sweep the leaf capacity of the quadtree for float and double coordinates
+ *
+ * Besides the timings, reports the size of a node and the share of the
+ * inline object slots of all nodes that hold an object.
+ *
+ * usage: capacity [max_exponent=6] [queries=10000] [extent=0.01]
+ */
+int bench_capacity(int argc, char* argv[]) {
+    const unsigned int max_exp = argc > 1 ? std::atoi(argv[1]) : 6;
+    const unsigned int nr_queries = argc > 2 ? std::atoi(argv[2]) : 10000;
+    const double extent = argc > 3 ? std::atof(argv[3]) : 0.01;
+
+    const std::vector<BenchPoint> queries = bench_uniform_points(nr_queries, 1);
+
+    std::cout << std::setw(10) << "points"
+              << std::setw(10) << "capacity"
+              << std::setw(8) << "coord"
+              << std::setw(12) << "build (s)"
+              << std::setw(14) << "range (ns/q)"
+              << std::setw(14) << "radius (ns/q)"
+              << std::setw(14) << "knn (ns/q)"
+              << std::setw(14) << "memory (MiB)"
+              << std::setw(10) << "node (B)"
+              << std::setw(12) << "slots (%)"
+              << std::setw(12) << "found" << std::endl;
+
+    for(unsigned int e=4; e<=max_exp; e++) {
+        size_t n = 1;
+        for(unsigned int i=0; i<e; i++) {
+            n *= 10;
+        }
+
+        std::vector<BenchPoint> points = bench_uniform_points(n, 42);
+        bench_capacities<float>("float", points, queries, extent);
+        bench_capacities<double>("double", points, queries, extent);
+    }
+
+    return 0;
+}
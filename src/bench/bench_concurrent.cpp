@@ -0,0 +1,148 @@
+/**************************************************************************
+ *   bench_concurrent.cpp  --  This file is part of Quadtree.              *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "bench/bench.h"
+#include "quadtree/concurrent_quadtree.h"
+
+typedef ConcurrentQuadTree<BenchPoint> BenchConcurrentTree;
+
+/**
+ * @brief       run reader threads (and optionally a writer) for a fixed time
+ *
+ * @param       inserts     points to insert by the writer; no writer is run when empty
+ */
+static void bench_readers(BenchConcurrentTree& tree, unsigned int nr_readers, double duration, unsigned int publish_interval,
+                          std::vector<BenchPoint>& inserts) {
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> nr_queries(0);
+    std::atomic<size_t> nr_found(0);
+
+    std::vector<std::thread> readers;
+    for(unsigned int r=0; r<nr_readers; r++) {
+        readers.push_back(std::thread([&tree, &stop, &nr_queries, &nr_found, r]() {
+            const unsigned int reader = tree.register_reader();
+            const std::vector<BenchPoint> queries = bench_uniform_points(4096, 100 + r);
+            std::vector<BenchConcurrentTree::Object> results;
+            BenchConcurrentTree::Tree::KnnScratch scratch;
+            size_t count = 0;
+            size_t found = 0;
+
+            while(!stop.load()) {
+                const BenchPoint& q = queries[count % queries.size()];
+                {
+                    BenchConcurrentTree::Snapshot snapshot = tree.snapshot(reader);
+                    results.clear();
+                    snapshot->query_range(q.x, q.y, q.x + 0.01, q.y + 0.01, results);
+                    found += results.size();
+                    snapshot->query_knn(q.x, q.y, 8, results, scratch);
+                    found += results.size();
+                }
+                count++;
+            }
+
+            nr_queries += count;
+            nr_found += found;
+            tree.unregister_reader(reader);
+        }));
+    }
+
+    size_t nr_inserted = 0;
+    size_t nr_published = 0;
+    size_t max_retired = 0;
+    double t_publish = 0.0;
+    BenchTimer timer;
+    if(inserts.empty()) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+    } else {
+        while(timer.elapsed() < duration && nr_inserted < inserts.size()) {
+            BenchPoint& p = inserts[nr_inserted++];
+            tree.add(&p, p.x, p.y);
+            BenchTimer publish_timer;
+            if(tree.publish_batched(publish_interval)) {
+                t_publish += publish_timer.elapsed();
+                nr_published++;
+                max_retired = std::max(max_retired, tree.get_nr_retired());
+            }
+        }
+        nr_published += tree.publish();
+        while(timer.elapsed() < duration) {
+            std::this_thread::yield();
+        }
+    }
+    const double elapsed = timer.elapsed();
+
+    stop.store(true);
+    for(auto& reader: readers) {
+        reader.join();
+    }
+
+    std::cout << std::setw(10) << nr_readers
+              << std::setw(10) << (inserts.empty() ? "no" : "yes")
+              << std::setw(16) << std::fixed << std::setprecision(0) << nr_queries.load() / elapsed
+              << std::setw(16) << nr_inserted / elapsed
+              << std::setw(12) << nr_published
+              << std::setw(14) << std::setprecision(3) << (nr_published > 0 ? t_publish / nr_published * 1e3 : 0.0)
+              << std::setw(12) << max_retired
+              << std::setw(14) << std::setprecision(0) << nr_found.load() << std::endl;
+}
+
+/**
+ * @brief       measure query throughput of snapshot readers with and without a concurrent writer
+ *
+ * Every reader query is a range query followed by a kNN query on a fresh snapshot.
+ *
+ * usage: concurrent [readers=2] [duration=2] [initial_points=100000] [publish_interval=1000]
+ */
+int bench_concurrent(int argc, char* argv[]) {
+    const unsigned int nr_readers = argc > 1 ? std::atoi(argv[1]) : 2;
+    const double duration = argc > 2 ? std::atof(argv[2]) : 2.0;
+    const size_t nr_initial = argc > 3 ? std::atol(argv[3]) : 100000;
+    const unsigned int publish_interval = argc > 4 ? std::max(1, std::atoi(argv[4])) : 1000;
+
+    std::vector<BenchPoint> initial = bench_uniform_points(nr_initial, 42);
+    std::vector<BenchPoint> inserts = bench_uniform_points(4000000, 43);
+    std::vector<BenchPoint> no_inserts;
+
+    BenchConcurrentTree tree(0.5, 0.5, 1.0, 1.0);
+    for(auto& p: initial) {
+        tree.add(&p, p.x, p.y);
+    }
+    tree.publish();
+
+    std::cout << std::setw(10) << "readers"
+              << std::setw(10) << "writer"
+              << std::setw(16) << "queries/s"
+              << std::setw(16) << "inserts/s"
+              << std::setw(12) << "publishes"
+              << std::setw(14) << "publish (ms)"
+              << std::setw(12) << "max retired"
+              << std::setw(14) << "found" << std::endl;
+
+    bench_readers(tree, nr_readers, duration, publish_interval, no_inserts);
+    bench_readers(tree, nr_readers, duration, publish_interval, inserts);
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**************************************************************************
+ *   bench_count.cpp  --  This file is part of Quadtree.                  *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+typedef QuadTree<BenchPoint> CountTree;
+
+/**
+ * @brief       number of points inside a rectangle, found by a linear scan
+ */
+static size_t bench_brute_count(const std::vector<BenchPoint>& points, const std::vector<bool>& removed,
+                                double xmin, double ymin, double xmax, double ymax) {
+    size_t count = 0;
+    for(size_t i=0; i<points.size(); i++) {
+        const BenchPoint& p = points[i];
+        count += !removed[i] && p.x >= xmin && p.x <= xmax && p.y >= ymin && p.y <= ymax;
+    }
+    return count;
+}
+
+/**
+ * @brief       compare counting queries with collecting range queries for growing rectangles
+ *
+ * Every tenth point is removed before the queries, such that the subtree
+ * counts are also checked after removals. The counts are compared with the
+ * size of the range query results, and for the first queries with a linear
+ * scan.
+ *
+ * usage: count [points=1000000] [queries=1000] [brute_queries=100]
+ */
+int bench_count(int argc, char* argv[]) {
+    const size_t nr_points = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const unsigned int nr_queries = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const unsigned int nr_brute = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_points, 42);
+    std::vector<CountTree::Object> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(CountTree::Object(&p, p.x, p.y));
+    }
+    CountTree tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+
+    std::vector<bool> removed(points.size(), false);
+    for(size_t i=0; i<points.size(); i+=10) {
+        removed[i] = tree.remove(&points[i], points[i].x, points[i].y);
+    }
+
+    const std::vector<BenchPoint> queries = bench_uniform_points(nr_queries, 1);
+    static const double extents[] = {0.001, 0.01, 0.1, 0.5};
+
+    std::cout << std::setw(10) << "extent"
+              << std::setw(14) << "count (ns/q)"
+              << std::setw(14) << "range (ns/q)"
+              << std::setw(10) << "speedup"
+              << std::setw(14) << "found"
+              << std::setw(12) << "mismatches" << std::endl;
+
+    size_t nr_mismatches = 0;
+    std::vector<size_t> counts(nr_queries);
+    std::vector<CountTree::Object> results;
+    for(double extent: extents) {
+        size_t nr_counted = 0;
+        BenchTimer count_timer;
+        for(unsigned int i=0; i<nr_queries; i++) {
+            counts[i] = tree.count(queries[i].x, queries[i].y, queries[i].x + extent, queries[i].y + extent);
+            nr_counted += counts[i];
+        }
+        const double t_count = count_timer.elapsed() / nr_queries;
+
+        size_t nr_extent_mismatches = 0;
+        BenchTimer range_timer;
+        for(unsigned int i=0; i<nr_queries; i++) {
+            results.clear();
+            tree.query_range(queries[i].x, queries[i].y, queries[i].x + extent, queries[i].y + extent, results);
+            nr_extent_mismatches += results.size() != counts[i];
+        }
+        const double t_range = range_timer.elapsed() / nr_queries;
+
+        for(unsigned int i=0; i<std::min(nr_brute, nr_queries); i++) {
+            nr_extent_mismatches += bench_brute_count(points, removed, queries[i].x, queries[i].y,
+                                                      queries[i].x + extent, queries[i].y + extent) != counts[i];
+        }
+        nr_mismatches += nr_extent_mismatches;
+
+        std::cout << std::setw(10) << extent
+                  << std::setw(14) << std::fixed << std::setprecision(0) << t_count * 1e9
+                  << std::setw(14) << t_range * 1e9
+                  << std::setw(10) << std::setprecision(1) << (t_count > 0 ? t_range / t_count : 0.0)
+                  << std::setw(14) << nr_counted
+                  << std::setw(12) << nr_extent_mismatches << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    return nr_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/**************************************************************************
+ *   bench_file.cpp  --  This file is part of Quadtree.                   *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+#include "quadtree/quadtree_file.h"
+
+/**
+ * @brief       save a quadtree, map it back and compare the queries on both
+ *
+ * usage: file [points=1000000] [queries=10000] [extent=0.01] [path=quadtree_bench.qtf]
+ */
+int bench_file(int argc, char* argv[]) {
+    const size_t nr_points = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const unsigned int nr_queries = argc > 2 ? std::atoi(argv[2]) : 10000;
+    const double extent = argc > 3 ? std::atof(argv[3]) : 0.01;
+    const std::string path = argc > 4 ? argv[4] : "quadtree_bench.qtf";
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_points, 42);
+    const std::vector<BenchPoint> queries = bench_uniform_points(nr_queries, 1);
+
+    std::vector<QuadTreeObject<BenchPoint>> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(QuadTreeObject<BenchPoint>(&p, p.x, p.y));
+    }
+    QuadTree<BenchPoint> tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+
+    // the index of a point in the vector serves as its identifier
+    const BenchPoint* first = points.data();
+    BenchTimer save_timer;
+    if(!quadtree_save(tree, path.c_str(), [first](const BenchPoint* p) { return uint64_t(p - first); })) {
+        return 1;
+    }
+    const double t_save = save_timer.elapsed();
+
+    MappedQuadTree<double, QuadTree<BenchPoint>::Node::max_depth> mapped;
+    BenchTimer open_timer;
+    if(!mapped.open(path.c_str())) {
+        return 1;
+    }
+    const double t_open = open_timer.elapsed();
+
+    std::vector<QuadTreeObject<BenchPoint>> results;
+    size_t nr_found = 0;
+    BenchTimer memory_timer;
+    for(const auto& q: queries) {
+        results.clear();
+        tree.query_range(q.x, q.y, q.x + extent, q.y + extent, results);
+        nr_found += results.size();
+    }
+    const double t_memory = memory_timer.elapsed() / queries.size();
+
+    std::vector<QuadTreeFileObject<double>> mapped_results;
+    size_t nr_mapped_found = 0;
+    BenchTimer mapped_timer;
+    for(const auto& q: queries) {
+        mapped_results.clear();
+        mapped.query_range(q.x, q.y, q.x + extent, q.y + extent, mapped_results);
+        nr_mapped_found += mapped_results.size();
+    }
+    const double t_mapped = mapped_timer.elapsed() / queries.size();
+
+    // the full check reads every node, so it runs after the timed queries
+    BenchTimer validate_timer;
+    if(!mapped.validate()) {
+        return 1;
+    }
+    const double t_validate = validate_timer.elapsed();
+
+    // both trees must return the same objects for every query
+    size_t nr_mismatches = 0;
+    std::vector<uint64_t> ids;
+    std::vector<uint64_t> mapped_ids;
+    for(const auto& q: queries) {
+        results.clear();
+        tree.query_range(q.x, q.y, q.x + extent, q.y + extent, results);
+        ids.clear();
+        for(const auto& obj: results) {
+            ids.push_back(uint64_t(obj.objptr - first));
+        }
+
+        mapped_results.clear();
+        mapped.query_range(q.x, q.y, q.x + extent, q.y + extent, mapped_results);
+        mapped_ids.clear();
+        for(const auto& obj: mapped_results) {
+            mapped_ids.push_back(obj.id);
+        }
+
+        std::sort(ids.begin(), ids.end());
+        std::sort(mapped_ids.begin(), mapped_ids.end());
+        nr_mismatches += ids != mapped_ids;
+    }
+
+    const QuadTreeStatistics stats = tree.get_statistics();
+    std::cout << "points:         " << nr_points << " (depth " << stats.depth << ")" << std::endl
+              << std::fixed << std::setprecision(3)
+              << "save:           " << t_save << " s" << std::endl
+              << "open:           " << t_open * 1e3 << " ms" << std::endl
+              << "validate:       " << t_validate * 1e3 << " ms" << std::endl
+              << std::setprecision(0)
+              << "range memory:   " << t_memory * 1e9 << " ns/q (" << nr_found << " found)" << std::endl
+              << "range mapped:   " << t_mapped * 1e9 << " ns/q (" << nr_mapped_found << " found)" << std::endl
+              << "mismatches:     " << nr_mismatches << std::endl;
+
+    mapped.close();
+    std::remove(path.c_str());
+
+    return nr_mismatches == 0 ? 0 : 1;
+}
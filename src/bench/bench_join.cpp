@@ -0,0 +1,165 @@
+/**************************************************************************
+ *   bench_join.cpp  --  This file is part of Quadtree.                   *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+// the trees differ in their leaf capacity, as join_range() and join_knn() accept any other tree
+typedef QuadTree<BenchPoint> JoinTree;
+typedef QuadTree<BenchPoint, 8> JoinOtherTree;
+typedef std::pair<const BenchPoint*, const BenchPoint*> PointerPair;
+
+/**
+ * @brief       find all pairs within a distance by scanning the other points sorted on x
+ */
+static std::vector<PointerPair> bench_join_scan(const std::vector<BenchPoint>& points, const std::vector<BenchPoint>& other, double r) {
+    std::vector<const BenchPoint*> sorted;
+    sorted.reserve(other.size());
+    for(const auto& p: other) {
+        sorted.push_back(&p);
+    }
+    const auto by_x = [](const BenchPoint* a, const BenchPoint* b) {
+        return a->x < b->x;
+    };
+    std::sort(sorted.begin(), sorted.end(), by_x);
+
+    const double r2 = r * r;
+    std::vector<PointerPair> result;
+    for(const auto& p: points) {
+        const BenchPoint lower(p.x - r, 0.0);
+        for(auto it = std::lower_bound(sorted.begin(), sorted.end(), &lower, by_x); it != sorted.end() && (*it)->x <= p.x + r; ++it) {
+            const double dx = (*it)->x - p.x;
+            const double dy = (*it)->y - p.y;
+            if(dx * dx + dy * dy <= r2) {
+                result.push_back(PointerPair(&p, *it));
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief       compare the dual-tree joins with per-object queries on the other tree
+ *
+ * join_range() must report the same pairs as a scan over the other points
+ * sorted on x. join_knn() must report, for every object, neighbours at the
+ * same distances as query_knn() on the other tree; distances are compared
+ * instead of objects, as ties may be broken differently.
+ *
+ * usage: join [points=100000] [other_points=1000000] [radius=0.001] [k=8]
+ */
+int bench_join(int argc, char* argv[]) {
+    const size_t nr_points = argc > 1 ? std::atol(argv[1]) : 100000;
+    const size_t nr_other = argc > 2 ? std::atol(argv[2]) : 1000000;
+    const double r = argc > 3 ? std::atof(argv[3]) : 0.001;
+    const unsigned int k = argc > 4 ? std::atoi(argv[4]) : 8;
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_points, 42);
+    std::vector<BenchPoint> other_points = bench_uniform_points(nr_other, 43);
+
+    std::vector<JoinTree::Object> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(JoinTree::Object(&p, p.x, p.y));
+    }
+    JoinTree tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+
+    std::vector<JoinOtherTree::Object> other_objs;
+    other_objs.reserve(other_points.size());
+    for(auto& p: other_points) {
+        other_objs.push_back(JoinOtherTree::Object(&p, p.x, p.y));
+    }
+    JoinOtherTree other(0.5, 0.5, 1.0, 1.0, other_objs.data(), other_objs.size());
+
+    std::vector<std::pair<JoinTree::Object, JoinOtherTree::Object>> pairs;
+
+    // range join against a scan of the sorted points
+    BenchTimer join_range_timer;
+    tree.join_range(other, r, pairs);
+    const double t_join_range = join_range_timer.elapsed();
+
+    std::vector<PointerPair> joined;
+    joined.reserve(pairs.size());
+    for(const auto& pair: pairs) {
+        joined.push_back(PointerPair(pair.first.objptr, pair.second.objptr));
+    }
+    std::sort(joined.begin(), joined.end());
+
+    BenchTimer scan_timer;
+    const std::vector<PointerPair> scanned = bench_join_scan(points, other_points, r);
+    const double t_scan = scan_timer.elapsed();
+    const bool range_equal = joined == scanned;
+
+    // kNN join against a kNN query per object
+    BenchTimer join_knn_timer;
+    tree.join_knn(other, k, pairs);
+    const double t_join_knn = join_knn_timer.elapsed();
+
+    std::unordered_map<const BenchPoint*, std::vector<double>> neighbours;
+    for(const auto& pair: pairs) {
+        const double dx = pair.second.x - pair.first.x;
+        const double dy = pair.second.y - pair.first.y;
+        neighbours[pair.first.objptr].push_back(dx * dx + dy * dy);
+    }
+
+    std::vector<JoinOtherTree::Object> results;
+    std::vector<std::vector<double>> expected(points.size());
+    BenchTimer knn_timer;
+    for(size_t i=0; i<points.size(); i++) {
+        other.query_knn(points[i].x, points[i].y, k, results);
+        for(const auto& obj: results) {
+            const double dx = obj.x - points[i].x;
+            const double dy = obj.y - points[i].y;
+            expected[i].push_back(dx * dx + dy * dy);
+        }
+    }
+    const double t_knn = knn_timer.elapsed();
+
+    size_t nr_knn_mismatches = 0;
+    for(size_t i=0; i<points.size(); i++) {
+        nr_knn_mismatches += neighbours[&points[i]] != expected[i];
+    }
+
+    std::cout << std::setw(10) << "join"
+              << std::setw(12) << "join (s)"
+              << std::setw(16) << "reference (s)"
+              << std::setw(12) << "pairs"
+              << std::setw(12) << "mismatches" << std::endl;
+    std::cout << std::setw(10) << "range"
+              << std::setw(12) << std::fixed << std::setprecision(3) << t_join_range
+              << std::setw(16) << t_scan
+              << std::setw(12) << joined.size()
+              << std::setw(12) << (range_equal ? 0 : 1) << std::endl;
+    std::cout << std::setw(10) << "knn"
+              << std::setw(12) << t_join_knn
+              << std::setw(16) << t_knn
+              << std::setw(12) << pairs.size()
+              << std::setw(12) << nr_knn_mismatches << std::endl;
+
+    return range_equal && nr_knn_mismatches == 0 ? 0 : 1;
+}
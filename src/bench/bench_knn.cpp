@@ -0,0 +1,130 @@
+/**************************************************************************
+ *   bench_knn.cpp  --  This file is part of Quadtree.                    *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+/**
+ * @brief       brute force k nearest neighbours, returns the k-th squared distance
+ */
+static double brute_force_knn(const std::vector<BenchPoint>& points, double x, double y, unsigned int k, std::vector<double>& heap) {
+    heap.clear();
+    for(const auto& p: points) {
+        const double d2 = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
+        if(heap.size() < k) {
+            heap.push_back(d2);
+            std::push_heap(heap.begin(), heap.end());
+        } else if(d2 < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = d2;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    return heap.front();
+}
+
+/**
+ * @brief       compare best-first kNN search against a brute force scan
+ *
+ * usage: knn [max_exponent=7] [k=8] [queries=1000]
+ */
+int bench_knn(int argc, char* argv[]) {
+    const unsigned int max_exp = argc > 1 ? std::atoi(argv[1]) : 7;
+    const unsigned int k = argc > 2 ? std::atoi(argv[2]) : 8;
+    const unsigned int nr_queries = argc > 3 ? std::atoi(argv[3]) : 1000;
+
+    // the brute force scan is only run on a subset of the queries
+    const unsigned int nr_brute_queries = std::min(nr_queries, 50u);
+
+    const std::vector<BenchPoint> queries = bench_uniform_points(nr_queries, 1);
+
+    std::cout << std::setw(10) << "points"
+              << std::setw(14) << "build (s)"
+              << std::setw(16) << "tree (ns/q)"
+              << std::setw(16) << "brute (ns/q)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for(unsigned int e=5; e<=max_exp; e++) {
+        size_t n = 1;
+        for(unsigned int i=0; i<e; i++) {
+            n *= 10;
+        }
+
+        std::vector<BenchPoint> points = bench_uniform_points(n, 42);
+
+        BenchTimer build_timer;
+        QuadTree<BenchPoint> tree(0.5, 0.5, 1.0, 1.0);
+        for(auto& p: points) {
+            tree.add(&p, p.x, p.y);
+        }
+        const double t_build = build_timer.elapsed();
+
+        // squared distance of the k-th neighbour found by the tree, checked after timing
+        std::vector<double> tree_dist2(nr_queries);
+        std::vector<QuadTreeObject<BenchPoint>> results;
+        double checksum_tree = 0.0;
+        BenchTimer tree_timer;
+        for(unsigned int i=0; i<nr_queries; i++) {
+            tree.query_knn(queries[i].x, queries[i].y, k, results);
+            const double dx = results.back().x - queries[i].x;
+            const double dy = results.back().y - queries[i].y;
+            tree_dist2[i] = dx * dx + dy * dy;
+            checksum_tree += results.back().x;
+        }
+        const double t_tree = tree_timer.elapsed() / nr_queries;
+
+        std::vector<double> heap;
+        std::vector<double> brute_dist2(nr_brute_queries);
+        BenchTimer brute_timer;
+        for(unsigned int i=0; i<nr_brute_queries; i++) {
+            brute_dist2[i] = brute_force_knn(points, queries[i].x, queries[i].y, k, heap);
+        }
+        const double t_brute = brute_timer.elapsed() / nr_brute_queries;
+
+        unsigned int mismatches = 0;
+        for(unsigned int i=0; i<nr_brute_queries; i++) {
+            if(tree_dist2[i] != brute_dist2[i]) {
+                mismatches++;
+            }
+        }
+
+        std::cout << std::setw(10) << n
+                  << std::setw(14) << std::fixed << std::setprecision(3) << t_build
+                  << std::setw(16) << std::setprecision(0) << t_tree * 1e9
+                  << std::setw(16) << t_brute * 1e9
+                  << std::setw(10) << std::setprecision(1) << t_brute / t_tree << std::endl;
+
+        if(mismatches != 0) {
+            std::cerr << "WARNING: " << mismatches << " queries differ from brute force" << std::endl;
+        }
+
+        // keep the optimizer from removing the query loop
+        if(checksum_tree < 0.0) {
+            std::cout << checksum_tree << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**************************************************************************
+ *   bench_linear.cpp  --  This file is part of Quadtree.                 *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+#include "quadtree/linear_quadtree.h"
+
+/**
+ * @brief       measure build, range query, kNN query and memory of a quadtree backend
+ */
+template <class Tree>
+static void bench_backend(const std::string& name, std::vector<BenchPoint>& points, const std::vector<BenchPoint>& queries, double extent) {
+    std::vector<QuadTreeObject<BenchPoint>> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(QuadTreeObject<BenchPoint>(&p, p.x, p.y));
+    }
+
+    BenchTimer build_timer;
+    Tree tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+    const double t_build = build_timer.elapsed();
+
+    std::vector<QuadTreeObject<BenchPoint>> results;
+    size_t nr_found = 0;
+    BenchTimer range_timer;
+    for(const auto& q: queries) {
+        results.clear();
+        tree.query_range(q.x, q.y, q.x + extent, q.y + extent, results);
+        nr_found += results.size();
+    }
+    const double t_range = range_timer.elapsed() / queries.size();
+
+    BenchTimer knn_timer;
+    for(const auto& q: queries) {
+        tree.query_knn(q.x, q.y, 8, results);
+        nr_found += results.size();
+    }
+    const double t_knn = knn_timer.elapsed() / queries.size();
+
+    std::cout << std::setw(10) << points.size()
+              << std::setw(10) << name
+              << std::setw(12) << std::fixed << std::setprecision(3) << t_build
+              << std::setw(14) << std::setprecision(0) << t_range * 1e9
+              << std::setw(14) << t_knn * 1e9
+              << std::setw(14) << std::setprecision(1) << tree.get_memory_usage() / (1024.0 * 1024.0)
+              << std::setw(12) << nr_found << std::endl;
+}
+
+/**
+ * @brief       compare the pointer-based and the linear (Morton-keyed) quadtree
+ *
+ * usage: linear [max_exponent=7] [queries=10000] [extent=0.01]
+ */
+int bench_linear(int argc, char* argv[]) {
+    const unsigned int max_exp = argc > 1 ? std::atoi(argv[1]) : 7;
+    const unsigned int nr_queries = argc > 2 ? std::atoi(argv[2]) : 10000;
+    const double extent = argc > 3 ? std::atof(argv[3]) : 0.01;
+
+    const std::vector<BenchPoint> queries = bench_uniform_points(nr_queries, 1);
+
+    std::cout << std::setw(10) << "points"
+              << std::setw(10) << "backend"
+              << std::setw(12) << "build (s)"
+              << std::setw(14) << "range (ns/q)"
+              << std::setw(14) << "knn (ns/q)"
+              << std::setw(14) << "memory (MiB)"
+              << std::setw(12) << "found" << std::endl;
+
+    for(unsigned int e=3; e<=max_exp; e++) {
+        size_t n = 1;
+        for(unsigned int i=0; i<e; i++) {
+            n *= 10;
+        }
+
+        std::vector<BenchPoint> points = bench_uniform_points(n, 42);
+        bench_backend<QuadTree<BenchPoint>>("pointer", points, queries, extent);
+        bench_backend<LinearQuadTree<BenchPoint>>("linear", points, queries, extent);
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**************************************************************************
+ *   bench_loose.cpp  --  This file is part of Quadtree.                  *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+#include "quadtree/loose_quadtree.h"
+
+/**
+ * @brief       compare a loose quadtree of boxes with a point quadtree of their centers on moving objects
+ *
+ * All objects are squares of the same size, such that a box overlaps with a
+ * rectangle exactly when its center lies in the rectangle grown by half the
+ * box size; the point quadtree answers the overlap queries that way. Every
+ * step moves all objects and then runs the queries on both trees, whose
+ * results are compared.
+ *
+ * usage: loose [objects=100000] [steps=20] [queries=1000] [size=0.002] [extent=0.01]
+ */
+int bench_loose(int argc, char* argv[]) {
+    const size_t nr_objects = argc > 1 ? std::atol(argv[1]) : 100000;
+    const unsigned int nr_steps = argc > 2 ? std::atoi(argv[2]) : 20;
+    const unsigned int nr_queries = argc > 3 ? std::atoi(argv[3]) : 1000;
+    const double size = argc > 4 ? std::atof(argv[4]) : 0.002;
+    const double extent = argc > 5 ? std::atof(argv[5]) : 0.01;
+    const double half = size / 2.0;
+
+    // keep the centers inside the half-open root of the point quadtree
+    const double upper = std::nextafter(1.0, 0.0);
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_objects, 42);
+    std::vector<BenchPoint> next = points;
+    std::vector<BenchPoint> velocities = bench_uniform_points(nr_objects, 7);
+    for(auto& v: velocities) {
+        v.x = (v.x - 0.5) * 0.01;
+        v.y = (v.y - 0.5) * 0.01;
+    }
+
+    std::vector<QuadTreeObject<BenchPoint>> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(QuadTreeObject<BenchPoint>(&p, p.x, p.y));
+    }
+
+    BenchTimer point_build_timer;
+    QuadTree<BenchPoint> point_tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+    const double t_point_build = point_build_timer.elapsed();
+
+    BenchTimer loose_build_timer;
+    LooseQuadTree<BenchPoint> loose_tree(0.5, 0.5, 1.0, 1.0);
+    for(auto& p: points) {
+        loose_tree.add(&p, p.x - half, p.y - half, p.x + half, p.y + half);
+    }
+    const double t_loose_build = loose_build_timer.elapsed();
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(0.0, 1.0 - extent);
+
+    double t_point_move = 0.0;
+    double t_loose_move = 0.0;
+    double t_point_query = 0.0;
+    double t_loose_query = 0.0;
+    size_t nr_failed = 0;
+    size_t nr_mismatches = 0;
+    size_t nr_found = 0;
+
+    std::vector<QuadTreeObject<BenchPoint>> point_results;
+    std::vector<LooseQuadTreeObject<BenchPoint>> loose_results;
+    std::vector<const BenchPoint*> point_hits;
+    std::vector<const BenchPoint*> loose_hits;
+
+    for(unsigned int s=0; s<nr_steps; s++) {
+        // bounce the objects off the edges of the unit square
+        for(size_t i=0; i<nr_objects; i++) {
+            BenchPoint& v = velocities[i];
+            double x = points[i].x + v.x;
+            double y = points[i].y + v.y;
+            if(x < 0.0 || x > upper) {
+                v.x = -v.x;
+                x = std::min(std::max(x, 0.0), upper);
+            }
+            if(y < 0.0 || y > upper) {
+                v.y = -v.y;
+                y = std::min(std::max(y, 0.0), upper);
+            }
+            next[i] = BenchPoint(x, y);
+        }
+
+        BenchTimer point_move_timer;
+        for(size_t i=0; i<nr_objects; i++) {
+            nr_failed += !point_tree.move(&points[i], points[i].x, points[i].y, next[i].x, next[i].y);
+        }
+        t_point_move += point_move_timer.elapsed();
+
+        BenchTimer loose_move_timer;
+        for(size_t i=0; i<nr_objects; i++) {
+            const BenchPoint& p = points[i];
+            const BenchPoint& q = next[i];
+            nr_failed += !loose_tree.move(&points[i], p.x - half, p.y - half, p.x + half, p.y + half,
+                                          q.x - half, q.y - half, q.x + half, q.y + half);
+        }
+        t_loose_move += loose_move_timer.elapsed();
+
+        for(size_t i=0; i<nr_objects; i++) {
+            points[i] = next[i];
+        }
+
+        for(unsigned int j=0; j<nr_queries; j++) {
+            const double x = dist(rng);
+            const double y = dist(rng);
+
+            point_results.clear();
+            BenchTimer point_query_timer;
+            point_tree.query_range(x - half, y - half, x + extent + half, y + extent + half, point_results);
+            t_point_query += point_query_timer.elapsed();
+
+            loose_results.clear();
+            BenchTimer loose_query_timer;
+            loose_tree.query_overlap(x, y, x + extent, y + extent, loose_results);
+            t_loose_query += loose_query_timer.elapsed();
+
+            point_hits.clear();
+            for(const auto& obj: point_results) {
+                point_hits.push_back(obj.objptr);
+            }
+            loose_hits.clear();
+            for(const auto& obj: loose_results) {
+                loose_hits.push_back(obj.objptr);
+            }
+            std::sort(point_hits.begin(), point_hits.end());
+            std::sort(loose_hits.begin(), loose_hits.end());
+            nr_mismatches += point_hits != loose_hits;
+            nr_found += loose_hits.size();
+        }
+    }
+
+    const double nr_moves = double(nr_objects) * nr_steps;
+    const double nr_total_queries = double(nr_queries) * nr_steps;
+
+    std::cout << std::setw(10) << "tree"
+              << std::setw(12) << "build (s)"
+              << std::setw(14) << "move (ns/op)"
+              << std::setw(14) << "query (ns/q)"
+              << std::setw(14) << "memory (MiB)" << std::endl;
+
+    std::cout << std::setw(10) << "point"
+              << std::setw(12) << std::fixed << std::setprecision(3) << t_point_build
+              << std::setw(14) << std::setprecision(0) << t_point_move / nr_moves * 1e9
+              << std::setw(14) << t_point_query / nr_total_queries * 1e9
+              << std::setw(14) << std::setprecision(1) << point_tree.get_memory_usage() / (1024.0 * 1024.0) << std::endl;
+
+    std::cout << std::setw(10) << "loose"
+              << std::setw(12) << std::fixed << std::setprecision(3) << t_loose_build
+              << std::setw(14) << std::setprecision(0) << t_loose_move / nr_moves * 1e9
+              << std::setw(14) << t_loose_query / nr_total_queries * 1e9
+              << std::setw(14) << std::setprecision(1) << loose_tree.get_memory_usage() / (1024.0 * 1024.0) << std::endl;
+
+    std::cout << "found " << nr_found << ", failed moves " << nr_failed << ", mismatches " << nr_mismatches << std::endl;
+
+    return nr_failed == 0 && nr_mismatches == 0 ? 0 : 1;
+}
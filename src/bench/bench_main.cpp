@@ -0,0 +1,89 @@
+/**************************************************************************
+ *   bench_main.cpp  --  This file is part of Quadtree.                   *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include "bench/bench.h"
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <benchmark> [options]" << std::endl;
+        std::cerr << "Available benchmarks: knn linear capacity concurrent file loose ray batch build pairs join count suite" << std::endl;
+        return 1;
+    }
+
+    const std::string name = argv[1];
+
+    if(name == "knn") {
+        return bench_knn(argc - 1, argv + 1);
+    }
+
+    if(name == "linear") {
+        return bench_linear(argc - 1, argv + 1);
+    }
+
+    if(name == "capacity") {
+        return bench_capacity(argc - 1, argv + 1);
+    }
+
+    if(name == "concurrent") {
+        return bench_concurrent(argc - 1, argv + 1);
+    }
+
+    if(name == "file") {
+        return bench_file(argc - 1, argv + 1);
+    }
+
+    if(name == "loose") {
+        return bench_loose(argc - 1, argv + 1);
+    }
+
+    if(name == "ray") {
+        return bench_ray(argc - 1, argv + 1);
+    }
+
+    if(name == "batch") {
+        return bench_batch(argc - 1, argv + 1);
+    }
+
+    if(name == "build") {
+        return bench_build(argc - 1, argv + 1);
+    }
+
+    if(name == "pairs") {
+        return bench_pairs(argc - 1, argv + 1);
+    }
+
+    if(name == "join") {
+        return bench_join(argc - 1, argv + 1);
+    }
+
+    if(name == "count") {
+        return bench_count(argc - 1, argv + 1);
+    }
+
+    if(name == "suite") {
+        return bench_suite(argc - 1, argv + 1);
+    }
+
+    std::cerr << "Unknown benchmark: " << name << std::endl;
+    return 1;
+}
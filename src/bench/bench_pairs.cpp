@@ -0,0 +1,140 @@
+/**************************************************************************
+ *   bench_pairs.cpp  --  This file is part of Quadtree.                  *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+typedef QuadTree<BenchPoint> PairTree;
+typedef std::pair<const BenchPoint*, const BenchPoint*> PointerPair;
+
+/**
+ * @brief       bring a list of unordered pairs into a canonical, sorted form
+ */
+static std::vector<PointerPair> bench_pairs_canonical(const std::vector<PairTree::ObjectPair>& pairs) {
+    std::vector<PointerPair> result;
+    result.reserve(pairs.size());
+    for(const auto& pair: pairs) {
+        const BenchPoint* a = pair.first.objptr;
+        const BenchPoint* b = pair.second.objptr;
+        result.push_back(a < b ? PointerPair(a, b) : PointerPair(b, a));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief       find all pairs within a distance by sweeping over the points sorted on x
+ */
+static std::vector<PointerPair> bench_pairs_sweep(const std::vector<BenchPoint>& points, double d) {
+    std::vector<const BenchPoint*> sorted;
+    sorted.reserve(points.size());
+    for(const auto& p: points) {
+        sorted.push_back(&p);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const BenchPoint* a, const BenchPoint* b) {
+        return a->x < b->x;
+    });
+
+    const double d2 = d * d;
+    std::vector<PointerPair> result;
+    for(size_t i=0; i<sorted.size(); i++) {
+        for(size_t j=i+1; j<sorted.size() && sorted[j]->x - sorted[i]->x <= d; j++) {
+            const double dx = sorted[j]->x - sorted[i]->x;
+            const double dy = sorted[j]->y - sorted[i]->y;
+            if(dx * dx + dy * dy <= d2) {
+                const BenchPoint* a = sorted[i];
+                const BenchPoint* b = sorted[j];
+                result.push_back(a < b ? PointerPair(a, b) : PointerPair(b, a));
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief       compare the serial and parallel pair queries with a sweep over the sorted points
+ *
+ * Every unordered pair within the distance must be reported exactly once
+ * by both pair queries.
+ *
+ * usage: pairs [points=1000000] [distance=0.001] [threads=0]
+ */
+int bench_pairs(int argc, char* argv[]) {
+    const size_t nr_points = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const double d = argc > 2 ? std::atof(argv[2]) : 0.001;
+    unsigned int nr_threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    if(nr_threads == 0) {
+        nr_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_points, 42);
+    std::vector<PairTree::Object> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(PairTree::Object(&p, p.x, p.y));
+    }
+    PairTree tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+
+    std::vector<PairTree::ObjectPair> pairs;
+    BenchTimer serial_timer;
+    tree.query_pairs(d, pairs);
+    const double t_serial = serial_timer.elapsed();
+    const std::vector<PointerPair> serial = bench_pairs_canonical(pairs);
+
+    BenchTimer parallel_timer;
+    tree.query_pairs_parallel(d, pairs, nr_threads);
+    const double t_parallel = parallel_timer.elapsed();
+    const std::vector<PointerPair> parallel = bench_pairs_canonical(pairs);
+
+    BenchTimer sweep_timer;
+    const std::vector<PointerPair> sweep = bench_pairs_sweep(points, d);
+    const double t_sweep = sweep_timer.elapsed();
+
+    std::cout << std::setw(10) << "method"
+              << std::setw(10) << "threads"
+              << std::setw(12) << "time (s)"
+              << std::setw(12) << "pairs"
+              << std::setw(10) << "equal" << std::endl;
+    std::cout << std::setw(10) << "serial"
+              << std::setw(10) << 1
+              << std::setw(12) << std::fixed << std::setprecision(3) << t_serial
+              << std::setw(12) << serial.size()
+              << std::setw(10) << (serial == sweep ? "yes" : "no") << std::endl;
+    std::cout << std::setw(10) << "parallel"
+              << std::setw(10) << nr_threads
+              << std::setw(12) << t_parallel
+              << std::setw(12) << parallel.size()
+              << std::setw(10) << (parallel == sweep ? "yes" : "no") << std::endl;
+    std::cout << std::setw(10) << "sweep"
+              << std::setw(10) << 1
+              << std::setw(12) << t_sweep
+              << std::setw(12) << sweep.size()
+              << std::setw(10) << "-" << std::endl;
+
+    return serial == sweep && parallel == sweep ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+/**************************************************************************
+ *   bench_ray.cpp  --  This file is part of Quadtree.                    *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+/**
+ * @brief       distance along a ray to the first disc around a point, found by a linear scan
+ *
+ * Uses the same arithmetic as QuadTree::query_ray(), such that the
+ * distances agree exactly.
+ *
+ * @return      whether a point was hit
+ */
+static bool bench_brute_ray(const std::vector<BenchPoint>& points, double ox, double oy, double dx, double dy, double r, double& best) {
+    const double len = std::sqrt(dx * dx + dy * dy);
+    dx /= len;
+    dy /= len;
+
+    const double r2 = r * r;
+    bool found = false;
+    best = std::numeric_limits<double>::max();
+    for(const auto& p: points) {
+        const double px = p.x - ox;
+        const double py = p.y - oy;
+        const double t = px * dx + py * dy;
+        const double e2 = px * px + py * py - t * t;
+        if(e2 > r2) {
+            continue;
+        }
+        const double half = std::sqrt(r2 - e2);
+        if(t + half < 0.0) {
+            continue;
+        }
+        best = std::min(best, std::max(t - half, 0.0));
+        found = true;
+    }
+    return found;
+}
+
+/**
+ * @brief       number of points within a distance of a line segment, found by a linear scan
+ */
+static size_t bench_brute_segment(const std::vector<BenchPoint>& points, double x0, double y0, double x1, double y1, double r) {
+    const double dx = x1 - x0;
+    const double dy = y1 - y0;
+    const double len2 = dx * dx + dy * dy;
+    const double r2 = r * r;
+    size_t count = 0;
+    for(const auto& p: points) {
+        const double px = p.x - x0;
+        const double py = p.y - y0;
+        const double t = len2 > 0 ? std::min(std::max((px * dx + py * dy) / len2, 0.0), 1.0) : 0.0;
+        const double ex = px - t * dx;
+        const double ey = py - t * dy;
+        count += ex * ex + ey * ey <= r2;
+    }
+    return count;
+}
+
+/**
+ * @brief       time ray and segment queries and check them against a linear scan
+ *
+ * The rays start at uniform positions in a uniform direction; the segments
+ * have uniform end points within a distance of 0.1 of their start.
+ *
+ * usage: ray [points=1000000] [queries=10000] [radius=0.001] [brute_queries=100]
+ */
+int bench_ray(int argc, char* argv[]) {
+    const size_t nr_points = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const unsigned int nr_queries = argc > 2 ? std::atoi(argv[2]) : 10000;
+    const double r = argc > 3 ? std::atof(argv[3]) : 0.001;
+    const unsigned int nr_brute = argc > 4 ? std::atoi(argv[4]) : 100;
+
+    std::vector<BenchPoint> points = bench_uniform_points(nr_points, 42);
+    std::vector<QuadTreeObject<BenchPoint>> objs;
+    objs.reserve(points.size());
+    for(auto& p: points) {
+        objs.push_back(QuadTreeObject<BenchPoint>(&p, p.x, p.y));
+    }
+    QuadTree<BenchPoint> tree(0.5, 0.5, 1.0, 1.0, objs.data(), objs.size());
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+    std::uniform_real_distribution<double> offset(-0.1, 0.1);
+    std::vector<BenchPoint> origins;
+    std::vector<BenchPoint> directions;
+    std::vector<BenchPoint> ends;
+    for(unsigned int i=0; i<nr_queries; i++) {
+        const double x = dist(rng);
+        const double y = dist(rng);
+        const double a = angle(rng);
+        const double ex = offset(rng);
+        const double ey = offset(rng);
+        origins.push_back(BenchPoint(x, y));
+        directions.push_back(BenchPoint(std::cos(a), std::sin(a)));
+        ends.push_back(BenchPoint(x + ex, y + ey));
+    }
+
+    std::vector<double> ray_dist(nr_queries, -1.0);
+    size_t nr_hits = 0;
+    BenchTimer ray_timer;
+    for(unsigned int i=0; i<nr_queries; i++) {
+        QuadTreeObject<BenchPoint> hit;
+        double d = 0.0;
+        if(tree.query_ray(origins[i].x, origins[i].y, directions[i].x, directions[i].y, r, hit, std::numeric_limits<double>::max(), &d)) {
+            ray_dist[i] = d;
+            nr_hits++;
+        }
+    }
+    const double t_ray = ray_timer.elapsed() / nr_queries;
+
+    std::vector<size_t> segment_count(nr_queries);
+    std::vector<QuadTreeObject<BenchPoint>> results;
+    size_t nr_found = 0;
+    BenchTimer segment_timer;
+    for(unsigned int i=0; i<nr_queries; i++) {
+        results.clear();
+        tree.query_segment(origins[i].x, origins[i].y, ends[i].x, ends[i].y, r, results);
+        segment_count[i] = results.size();
+        nr_found += results.size();
+    }
+    const double t_segment = segment_timer.elapsed() / nr_queries;
+
+    // the brute-force answers are timed separately from the tree queries
+    const unsigned int nr_checked = std::min(nr_brute, nr_queries);
+    std::vector<double> brute_ray_dist(nr_checked, -1.0);
+    BenchTimer brute_ray_timer;
+    for(unsigned int i=0; i<nr_checked; i++) {
+        double d = 0.0;
+        if(bench_brute_ray(points, origins[i].x, origins[i].y, directions[i].x, directions[i].y, r, d)) {
+            brute_ray_dist[i] = d;
+        }
+    }
+    const double t_brute_ray = nr_checked > 0 ? brute_ray_timer.elapsed() / nr_checked : 0.0;
+
+    std::vector<size_t> brute_segment_count(nr_checked);
+    BenchTimer brute_segment_timer;
+    for(unsigned int i=0; i<nr_checked; i++) {
+        brute_segment_count[i] = bench_brute_segment(points, origins[i].x, origins[i].y, ends[i].x, ends[i].y, r);
+    }
+    const double t_brute_segment = nr_checked > 0 ? brute_segment_timer.elapsed() / nr_checked : 0.0;
+
+    size_t nr_mismatches = 0;
+    for(unsigned int i=0; i<nr_checked; i++) {
+        nr_mismatches += ray_dist[i] != brute_ray_dist[i];
+        nr_mismatches += segment_count[i] != brute_segment_count[i];
+    }
+
+    std::cout << std::setw(10) << "query"
+              << std::setw(14) << "tree (ns/q)"
+              << std::setw(14) << "brute (ns/q)"
+              << std::setw(12) << "found" << std::endl;
+    std::cout << std::setw(10) << "ray"
+              << std::setw(14) << std::fixed << std::setprecision(0) << t_ray * 1e9
+              << std::setw(14) << t_brute_ray * 1e9
+              << std::setw(12) << nr_hits << std::endl;
+    std::cout << std::setw(10) << "segment"
+              << std::setw(14) << t_segment * 1e9
+              << std::setw(14) << t_brute_segment * 1e9
+              << std::setw(12) << nr_found << std::endl;
+    std::cout << "mismatches " << nr_mismatches << " in " << nr_checked << " checked queries" << std::endl;
+
+    return nr_mismatches == 0 ? 0 : 1;
+}
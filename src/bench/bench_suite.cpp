@@ -0,0 +1,477 @@
+/**************************************************************************
+ *   bench_suite.cpp  --  This file is part of Quadtree.                  *
+ *                                                                        *
+ *   Copyright (C) 2016, Ivo Filot                                        *
+ *                                                                        *
+ *   Netris is free software: you can redistribute it and/or modify       *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   Netris is distributed in the hope that it will be useful,            *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench/bench.h"
+#include "quadtree/quadtree.h"
+
+typedef QuadTree<BenchPoint> SuiteTree;
+
+/**
+ * @brief       measurements for one distribution and number of points (times in ns/op)
+ */
+class SuiteResult {
+public:
+    std::string distribution;
+    size_t nr_points;
+    unsigned int depth;
+    size_t nr_nodes;
+    long peak_rss_kib;
+
+    double insert;
+    double bulk;
+    double range;
+    double radius;
+    double knn;
+    double remove;
+
+    double brute_range;
+    double brute_radius;
+    double brute_knn;
+
+    size_t nr_mismatches;   // brute-force queries whose answer differs from the tree
+
+    SuiteResult() :
+        nr_points(0), depth(0), nr_nodes(0), peak_rss_kib(0),
+        insert(0), bulk(0), range(0), radius(0), knn(0), remove(0),
+        brute_range(0), brute_radius(0), brute_knn(0),
+        nr_mismatches(0) {}
+};
+
+/**
+ * @brief       generate points following one of the benchmark distributions
+ *
+ * uniform:     uniform in the unit square
+ * clusters:    16 Gaussian clusters (sigma 0.02) at uniform centers
+ * curve:       exactly on the curve y = 0.5 + 0.3 sin(4 pi x)
+ * duplicates:  about sqrt(n) distinct positions, each repeated about sqrt(n) times
+ * powerlaw:    x = u^4, y = v^4, concentrating the points near the origin
+ */
+static std::vector<BenchPoint> suite_points(const std::string& distribution, size_t n, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<BenchPoint> points;
+    points.reserve(n);
+
+    if(distribution == "uniform") {
+        return bench_uniform_points(n, seed);
+    }
+
+    if(distribution == "clusters") {
+        // the centers do not depend on the seed, such that queries follow the data
+        std::mt19937 center_rng(7);
+        std::uniform_real_distribution<double> center_dist(0.1, 0.9);
+        std::vector<BenchPoint> centers;
+        for(unsigned int i=0; i<16; i++) {
+            const double x = center_dist(center_rng);
+            const double y = center_dist(center_rng);
+            centers.push_back(BenchPoint(x, y));
+        }
+
+        std::normal_distribution<double> offset(0.0, 0.02);
+        std::uniform_int_distribution<size_t> pick(0, centers.size() - 1);
+        while(points.size() < n) {
+            const BenchPoint& c = centers[pick(rng)];
+            const double x = c.x + offset(rng);
+            const double y = c.y + offset(rng);
+            if(x >= 0.0 && x < 1.0 && y >= 0.0 && y < 1.0) {
+                points.push_back(BenchPoint(x, y));
+            }
+        }
+        return points;
+    }
+
+    if(distribution == "curve") {
+        for(size_t i=0; i<n; i++) {
+            const double x = dist(rng);
+            points.push_back(BenchPoint(x, 0.5 + 0.3 * std::sin(4.0 * M_PI * x)));
+        }
+        return points;
+    }
+
+    if(distribution == "duplicates") {
+        const size_t nr_sites = std::max(size_t(1), size_t(std::sqrt(double(n))));
+        const std::vector<BenchPoint> sites = bench_uniform_points(nr_sites, 7);
+        std::uniform_int_distribution<size_t> pick(0, nr_sites - 1);
+        for(size_t i=0; i<n; i++) {
+            points.push_back(sites[pick(rng)]);
+        }
+        return points;
+    }
+
+    // powerlaw
+    for(size_t i=0; i<n; i++) {
+        const double u = dist(rng);
+        const double v = dist(rng);
+        points.push_back(BenchPoint(u * u * u * u, v * v * v * v));
+    }
+    return points;
+}
+
+/**
+ * @brief       peak resident set size in KiB from resource usage
+ */
+static long suite_peak_rss(const struct rusage& usage) {
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * @brief       squared distance of the k-th nearest point, found by a linear scan
+ */
+static double suite_brute_knn(const std::vector<BenchPoint>& points, double x, double y, unsigned int k) {
+    std::priority_queue<double> nearest;
+    for(const auto& p: points) {
+        const double d2 = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
+        if(nearest.size() < k) {
+            nearest.push(d2);
+        } else if(d2 < nearest.top()) {
+            nearest.pop();
+            nearest.push(d2);
+        }
+    }
+    return nearest.empty() ? 0.0 : nearest.top();
+}
+
+/**
+ * @brief       run all operations for one distribution and number of points
+ */
+static SuiteResult suite_run(const std::string& distribution, size_t n, size_t nr_queries, unsigned int k) {
+    static const double expected_hits = 16.0;       // hits of a range query on uniform data
+    static const size_t max_removals = 100000;
+    static const double brute_budget = 2e8;         // point visits per brute-force operation
+
+    SuiteResult result;
+    result.distribution = distribution;
+    result.nr_points = n;
+
+    std::vector<BenchPoint> points = suite_points(distribution, n, 42);
+    const std::vector<BenchPoint> queries = suite_points(distribution, nr_queries, 1);
+    const double extent = std::sqrt(expected_hits / n);
+    const double r = std::sqrt(expected_hits / (M_PI * n));
+
+    std::vector<SuiteTree::Object> objs;
+    objs.reserve(n);
+    for(auto& p: points) {
+        objs.push_back(SuiteTree::Object(&p, p.x, p.y));
+    }
+
+    std::vector<SuiteTree::Object> results;
+    std::vector<size_t> nr_range_found(queries.size());
+    std::vector<size_t> nr_radius_found(queries.size());
+    std::vector<double> knn_dist2(queries.size());
+
+    {
+        BenchTimer bulk_timer;
+        SuiteTree tree(0.5, 0.5, 1, 1, objs.data(), objs.size());
+        result.bulk = bulk_timer.elapsed() * 1e9 / n;
+        const QuadTreeStatistics stats = tree.get_statistics();
+        result.nr_nodes = stats.nr_nodes;
+        result.depth = stats.depth;
+
+        BenchTimer range_timer;
+        for(size_t i=0; i<queries.size(); i++) {
+            results.clear();
+            tree.query_range(queries[i].x - extent / 2, queries[i].y - extent / 2, queries[i].x + extent / 2, queries[i].y + extent / 2, results);
+            nr_range_found[i] = results.size();
+        }
+        result.range = range_timer.elapsed() * 1e9 / queries.size();
+
+        BenchTimer radius_timer;
+        for(size_t i=0; i<queries.size(); i++) {
+            results.clear();
+            tree.query_radius(queries[i].x, queries[i].y, r, results);
+            nr_radius_found[i] = results.size();
+        }
+        result.radius = radius_timer.elapsed() * 1e9 / queries.size();
+
+        BenchTimer knn_timer;
+        for(size_t i=0; i<queries.size(); i++) {
+            tree.query_knn(queries[i].x, queries[i].y, k, results);
+            double d2 = 0.0;
+            for(const auto& obj: results) {
+                d2 = std::max(d2, (obj.x - queries[i].x) * (obj.x - queries[i].x) + (obj.y - queries[i].y) * (obj.y - queries[i].y));
+            }
+            knn_dist2[i] = d2;
+        }
+        result.knn = knn_timer.elapsed() * 1e9 / queries.size();
+    }
+
+    {
+        BenchTimer insert_timer;
+        SuiteTree tree(0.5, 0.5, 1, 1);
+        for(const auto& obj: objs) {
+            tree.add(obj.objptr, obj.x, obj.y);
+        }
+        result.insert = insert_timer.elapsed() * 1e9 / n;
+
+        const size_t nr_removals = std::min(n, max_removals);
+        BenchTimer remove_timer;
+        for(size_t i=0; i<nr_removals; i++) {
+            tree.remove(objs[i].objptr, objs[i].x, objs[i].y);
+        }
+        result.remove = remove_timer.elapsed() * 1e9 / nr_removals;
+    }
+
+    // linear scans over the points, on as many queries as the budget allows
+    const size_t nr_brute = std::max(size_t(1), std::min(queries.size(), size_t(brute_budget / n)));
+
+    BenchTimer brute_range_timer;
+    for(size_t i=0; i<nr_brute; i++) {
+        const double xmin = queries[i].x - extent / 2;
+        const double ymin = queries[i].y - extent / 2;
+        const double xmax = queries[i].x + extent / 2;
+        const double ymax = queries[i].y + extent / 2;
+        size_t count = 0;
+        for(const auto& p: points) {
+            count += (p.x >= xmin && p.x <= xmax && p.y >= ymin && p.y <= ymax);
+        }
+        result.nr_mismatches += (count != nr_range_found[i]);
+    }
+    result.brute_range = brute_range_timer.elapsed() * 1e9 / nr_brute;
+
+    BenchTimer brute_radius_timer;
+    for(size_t i=0; i<nr_brute; i++) {
+        size_t count = 0;
+        for(const auto& p: points) {
+            count += ((p.x - queries[i].x) * (p.x - queries[i].x) + (p.y - queries[i].y) * (p.y - queries[i].y) <= r * r);
+        }
+        result.nr_mismatches += (count != nr_radius_found[i]);
+    }
+    result.brute_radius = brute_radius_timer.elapsed() * 1e9 / nr_brute;
+
+    BenchTimer brute_knn_timer;
+    for(size_t i=0; i<nr_brute; i++) {
+        const double d2 = suite_brute_knn(points, queries[i].x, queries[i].y, k);
+        result.nr_mismatches += (d2 != knn_dist2[i]);
+    }
+    result.brute_knn = brute_knn_timer.elapsed() * 1e9 / nr_brute;
+
+    return result;
+}
+
+/**
+ * @brief       run suite_run() in a child process and measure its peak resident set size
+ *
+ * The peak of a process never decreases, so every configuration gets a
+ * fresh process; its measurements are passed back through a pipe.
+ *
+ * @return      true when the child delivered its results
+ */
+static bool suite_run_isolated(const std::string& distribution, size_t n, size_t nr_queries, unsigned int k, SuiteResult& result) {
+    static const size_t nr_values = 12;
+
+    int fds[2];
+    if(pipe(fds) != 0) {
+        std::cerr << "Cannot create pipe for " << distribution << " with " << n << " points" << std::endl;
+        return false;
+    }
+
+    std::cout.flush();
+    const pid_t pid = fork();
+    if(pid < 0) {
+        std::cerr << "Cannot fork for " << distribution << " with " << n << " points" << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if(pid == 0) {
+        close(fds[0]);
+        const SuiteResult res = suite_run(distribution, n, nr_queries, k);
+        const double values[nr_values] = {
+            double(res.depth), double(res.nr_nodes),
+            res.insert, res.bulk, res.range, res.radius, res.knn, res.remove,
+            res.brute_range, res.brute_radius, res.brute_knn,
+            double(res.nr_mismatches)
+        };
+        const ssize_t nr_written = write(fds[1], values, sizeof(values));
+        close(fds[1]);
+        _exit(nr_written == ssize_t(sizeof(values)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    double values[nr_values];
+    size_t nr_read = 0;
+    while(nr_read < sizeof(values)) {
+        const ssize_t r = read(fds[0], reinterpret_cast<char*>(values) + nr_read, sizeof(values) - nr_read);
+        if(r <= 0) {
+            break;
+        }
+        nr_read += size_t(r);
+    }
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || nr_read != sizeof(values)) {
+        std::cerr << "Benchmark process for " << distribution << " with " << n << " points failed" << std::endl;
+        return false;
+    }
+
+    result = SuiteResult();
+    result.distribution = distribution;
+    result.nr_points = n;
+    result.depth = static_cast<unsigned int>(values[0]);
+    result.nr_nodes = static_cast<size_t>(values[1]);
+    result.insert = values[2];
+    result.bulk = values[3];
+    result.range = values[4];
+    result.radius = values[5];
+    result.knn = values[6];
+    result.remove = values[7];
+    result.brute_range = values[8];
+    result.brute_radius = values[9];
+    result.brute_knn = values[10];
+    result.nr_mismatches = static_cast<size_t>(values[11]);
+    result.peak_rss_kib = suite_peak_rss(usage);
+    return true;
+}
+
+/**
+ * @brief       write the results as a JSON document
+ */
+static void suite_write_json(std::ostream& out, const std::vector<SuiteResult>& results, size_t nr_queries, unsigned int k) {
+    out << "{\n"
+        << "  \"benchmark\": \"suite\",\n"
+        << "  \"queries\": " << nr_queries << ",\n"
+        << "  \"k\": " << k << ",\n"
+        << "  \"unit\": \"ns/op\",\n"
+        << "  \"results\": [\n";
+    out << std::setprecision(6);
+    for(size_t i=0; i<results.size(); i++) {
+        const SuiteResult& res = results[i];
+        out << "    {\"distribution\": \"" << res.distribution << "\""
+            << ", \"points\": " << res.nr_points
+            << ", \"depth\": " << res.depth
+            << ", \"nodes\": " << res.nr_nodes
+            << ", \"peak_rss_kib\": " << res.peak_rss_kib
+            << ", \"insert\": " << res.insert
+            << ", \"bulk\": " << res.bulk
+            << ", \"range\": " << res.range
+            << ", \"radius\": " << res.radius
+            << ", \"knn\": " << res.knn
+            << ", \"remove\": " << res.remove
+            << ", \"brute_range\": " << res.brute_range
+            << ", \"brute_radius\": " << res.brute_radius
+            << ", \"brute_knn\": " << res.brute_knn
+            << ", \"mismatches\": " << res.nr_mismatches
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n"
+        << "}\n";
+}
+
+/**
+ * @brief       measure all operations on the standard point distributions
+ *
+ * The range and radius queries are sized to hold 16 points on uniform data,
+ * and are centered on points drawn from the same distribution as the data.
+ * Removal is timed on the first 100000 points of the incrementally built tree.
+ * The brute-force baseline scans all points for as many queries as fit in
+ * 2e8 point visits and also checks the answers of the tree. Every row runs
+ * in its own process, whose peak resident set size is reported.
+ *
+ * usage: suite [min_exponent=3] [max_exponent=6] [queries=1000] [json_file]
+ *        (remove is timed on the first 1e5 points only)
+ */
+int bench_suite(int argc, char* argv[]) {
+    const unsigned int min_exp = argc > 1 ? std::atoi(argv[1]) : 3;
+    const unsigned int max_exp = argc > 2 ? std::atoi(argv[2]) : 6;
+    const size_t nr_queries = argc > 3 ? std::atoi(argv[3]) : 1000;
+    const std::string json_file = argc > 4 ? argv[4] : "";
+    const unsigned int k = 8;
+
+    static const char* distributions[] = {"uniform", "clusters", "curve", "duplicates", "powerlaw"};
+
+    std::cout << "times in ns/op; remove is timed on the first 1e5 points only; rss is the peak of a separate process per row" << std::endl;
+    std::cout << std::setw(12) << "distribution"
+              << std::setw(11) << "points"
+              << std::setw(7) << "depth"
+              << std::setw(11) << "nodes"
+              << std::setw(10) << "insert"
+              << std::setw(10) << "bulk"
+              << std::setw(10) << "range"
+              << std::setw(10) << "radius"
+              << std::setw(10) << "knn"
+              << std::setw(10) << "remove"
+              << std::setw(12) << "bf range"
+              << std::setw(12) << "bf radius"
+              << std::setw(12) << "bf knn"
+              << std::setw(12) << "rss (MiB)"
+              << std::setw(6) << "err" << std::endl;
+
+    std::vector<SuiteResult> results;
+    for(unsigned int e=min_exp; e<=max_exp; e++) {
+        size_t n = 1;
+        for(unsigned int i=0; i<e; i++) {
+            n *= 10;
+        }
+
+        for(const char* distribution: distributions) {
+            SuiteResult res;
+            if(!suite_run_isolated(distribution, n, nr_queries, k, res)) {
+                return 1;
+            }
+            results.push_back(res);
+
+            std::cout << std::setw(12) << res.distribution
+                      << std::setw(11) << res.nr_points
+                      << std::setw(7) << res.depth
+                      << std::setw(11) << res.nr_nodes
+                      << std::fixed << std::setprecision(0)
+                      << std::setw(10) << res.insert
+                      << std::setw(10) << res.bulk
+                      << std::setw(10) << res.range
+                      << std::setw(10) << res.radius
+                      << std::setw(10) << res.knn
+                      << std::setw(10) << res.remove
+                      << std::setw(12) << res.brute_range
+                      << std::setw(12) << res.brute_radius
+                      << std::setw(12) << res.brute_knn
+                      << std::setw(12) << std::setprecision(1) << res.peak_rss_kib / 1024.0
+                      << std::setw(6) << res.nr_mismatches << std::endl;
+        }
+    }
+
+    if(!json_file.empty()) {
+        std::ofstream out(json_file);
+        if(!out) {
+            std::cerr << "Cannot write " << json_file << std::endl;
+            return 1;
+        }
+        suite_write_json(out, results, nr_queries, k);
+    }
+
+    return 0;
+}
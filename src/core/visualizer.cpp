@@ -32,6 +32,8 @@
 void Visualizer::run(int argc, char* argv[]) {
     if(argc > 2) {
         std::cerr << "Invalid number of arguments" << std::endl;
+    } else if(argc == 2) {
+        Field::get().load_points(argv[1]);
     }
 
     /**
@@ -72,7 +74,12 @@ void Visualizer::run(int argc, char* argv[]) {
         if(current_time - last_time >= 1.0) {
 
             std::string sfps = boost::lexical_cast<std::string>(this->num_frames);
-            Display::get().set_window_title("Quadtree");
+            const QuadTreeStatistics stats = Field::get().get_statistics();
+            Display::get().set_window_title("Quadtree - " + sfps + " fps - " +
+                                            boost::lexical_cast<std::string>(stats.nr_objects) + " points, " +
+                                            boost::lexical_cast<std::string>(stats.nr_nodes) + " nodes, " +
+                                            boost::lexical_cast<std::string>(stats.nr_leaves) + " leaves, " +
+                                            boost::lexical_cast<std::string>(stats.bytes_used / 1024) + " KiB");
 
             // place in the function any commands that should be done every second
             this->update_second();
@@ -118,6 +125,8 @@ void Visualizer::handle_key_down(int key, int scancode, int action, int mods) {
                    && mods & GLFW_MOD_ALT
                    && action == GLFW_RELEASE) {
         glfwSetWindowShouldClose(Display::get().get_window_ptr(), GL_TRUE);
+    } else if(key == 'L' && action == GLFW_RELEASE) {
+        Field::get().toggle_layout();
     } else {
         // parse keys to the game engine
     }
@@ -140,7 +149,11 @@ void Visualizer::handle_mouse_key_down(int button, int action, int mods) {
     if(action == GLFW_RELEASE) {
         float x = (float)Mouse::get().get_x_sw() / (float)Screen::get().get_width();
         float y = (float)Mouse::get().get_y_sw() / (float)Screen::get().get_height();
-        Field::get().add_point(x, y);
+        if(button == GLFW_MOUSE_BUTTON_RIGHT) {
+            Field::get().pick_point(x, y);
+        } else {
+            Field::get().add_point(x, y);
+        }
     }
 }
 
@@ -202,7 +215,7 @@ Visualizer::Visualizer():
  * @return Game class
  */
 void Visualizer::update(double dt) {
-
+    Field::get().update(dt);
 }
 
 void Visualizer::update_second() {
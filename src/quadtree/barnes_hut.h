@@ -0,0 +1,167 @@
+#ifndef _QUAD_TREE_BARNES_HUT
+#define _QUAD_TREE_BARNES_HUT
+
+#include <vector>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#include "quadtree/quadtree.h"
+
+/**
+ * @brief       Barnes-Hut approximation of pairwise inverse-square interactions
+ *
+ * The field at a position is the sum over all objects of
+ *
+ *      strength * m * d / (|d|^2 + softening^2)^(3/2)
+ *
+ * with m the mass of an object (see QuadTreeMass) and d the vector from the
+ * position to the object. A positive strength attracts (gravity), a negative
+ * strength repels. Subtrees that appear small from the position, i.e. whose
+ * width is less than theta times the distance to their center of mass, are
+ * replaced by a single object at that center of mass carrying the total mass
+ * of the subtree. Evaluating the field for all objects takes O(n log n).
+ *
+ * @tparam      Tree        QuadTree type
+ */
+template <class Tree>
+class QuadTreeBarnesHut {
+public:
+    typedef typename Tree::Node Node;
+    typedef typename Tree::Object Object;
+    typedef typename Node::coord_type Coord;
+
+private:
+    Coord theta;        // opening angle
+    Coord strength;     // interaction constant; negative for repulsion
+    Coord softening;    // length that bounds the interaction at short distances
+
+    static const size_t chunk_size = 256;   // objects per work item of evaluate_all()
+
+public:
+    QuadTreeBarnesHut(Coord _theta = Coord(0.5), Coord _strength = Coord(1), Coord _softening = Coord(1e-3)) :
+        theta(_theta),
+        strength(_strength),
+        softening(_softening) {}
+
+    inline void set_theta(Coord _theta) {
+        this->theta = _theta;
+    }
+
+    inline void set_strength(Coord _strength) {
+        this->strength = _strength;
+    }
+
+    inline void set_softening(Coord _softening) {
+        this->softening = _softening;
+    }
+
+    /**
+     * @brief       calculate the field at a position
+     *
+     * Sources at zero displacement (an object at the position itself, or an
+     * aggregate whose center of mass lies there) are skipped, such that the
+     * field on an object stored in the tree excludes its self-interaction and
+     * stays finite without softening.
+     *
+     * @param       tree        tree holding the sources
+     * @param       x           x position
+     * @param       y           y position
+     * @param       fx          receives the x component of the field
+     * @param       fy          receives the y component of the field
+     */
+    void evaluate(const Tree& tree, Coord x, Coord y, Coord& fx, Coord& fy) const {
+        fx = 0;
+        fy = 0;
+        if(tree.get_root() == nullptr) {
+            return;
+        }
+
+        const Coord theta2 = this->theta * this->theta;
+        const Coord eps2 = this->softening * this->softening;
+        const Coord strength = this->strength;
+
+        QuadTreeTraversal<const Node>::pruned(tree.get_root(), [&](const Node* node) -> bool {
+            if(node->get_count() == 0) {
+                return false;
+            }
+
+            if(!node->has_children()) {
+                for(const Node* chain = node; chain != nullptr; chain = chain->get_overflow()) {
+                    for(unsigned int i=0; i<chain->get_nr_objects(); i++) {
+                        const Object obj = chain->get_object(i);
+                        QuadTreeBarnesHut::interact(obj.x - x, obj.y - y, Node::object_mass(obj), eps2, strength, fx, fy);
+                    }
+                }
+                return false;
+            }
+
+            Coord comx, comy;
+            node->get_center_of_mass(comx, comy);
+            const Coord dx = comx - x;
+            const Coord dy = comy - y;
+            const Coord size = std::max(node->get_width(), node->get_height());
+
+            // a node holding the position is always opened
+            if(!node->contains(x, y) && size * size < theta2 * (dx * dx + dy * dy)) {
+                QuadTreeBarnesHut::interact(dx, dy, node->get_mass(), eps2, strength, fx, fy);
+                return false;
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       calculate the field at the positions of a number of objects
+     *
+     * The objects are handed out to the threads in chunks. Passing the
+     * objects in Morton order (e.g. as collected from the tree) lets
+     * consecutive evaluations visit the same nodes.
+     *
+     * @param       tree        tree holding the sources
+     * @param       objs        objects at whose positions the field is evaluated
+     * @param       nr_objs     number of objects
+     * @param       fx          array of nr_objs elements receiving the x components
+     * @param       fy          array of nr_objs elements receiving the y components
+     * @param       nr_threads  number of threads (0 uses all hardware threads)
+     */
+    void evaluate_all(const Tree& tree, const Object* objs, size_t nr_objs, Coord* fx, Coord* fy, unsigned int nr_threads = 0) const {
+        if(nr_threads == 0) {
+            nr_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const size_t nr_chunks = (nr_objs + chunk_size - 1) / chunk_size;
+        nr_threads = unsigned(std::max(size_t(1), std::min(size_t(nr_threads), nr_chunks)));
+
+        std::atomic<size_t> next_chunk(0);
+        Tree::run_threads(nr_threads, [&](unsigned int) {
+            size_t c;
+            while((c = next_chunk++) < nr_chunks) {
+                const size_t end = std::min(nr_objs, (c + 1) * chunk_size);
+                for(size_t i=c*chunk_size; i<end; i++) {
+                    this->evaluate(tree, objs[i].x, objs[i].y, fx[i], fy[i]);
+                }
+            }
+        });
+    }
+
+private:
+    /**
+     * @brief       add the field of a point mass at displacement (dx, dy)
+     *
+     * A source at zero displacement exerts no force; skipping it avoids 0/0
+     * when the softening is zero.
+     */
+    static inline void interact(Coord dx, Coord dy, Coord m, Coord eps2, Coord strength, Coord& fx, Coord& fy) {
+        if(dx == 0 && dy == 0) {
+            return;
+        }
+        const Coord r2 = dx * dx + dy * dy + eps2;
+        const Coord f = strength * m / (r2 * std::sqrt(r2));
+        fx += f * dx;
+        fy += f * dy;
+    }
+};
+
+#endif //_QUAD_TREE_BARNES_HUT
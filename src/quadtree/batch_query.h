@@ -0,0 +1,89 @@
+#ifndef _QUAD_TREE_BATCH_QUERY
+#define _QUAD_TREE_BATCH_QUERY
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief       axis-aligned rectangle for batched range queries
+ */
+template <class Coord = double>
+class QuadTreeRangeQuery {
+public:
+    QuadTreeRangeQuery() :
+    xmin(0),
+    ymin(0),
+    xmax(0),
+    ymax(0) {}
+
+    QuadTreeRangeQuery(Coord _xmin, Coord _ymin, Coord _xmax, Coord _ymax) :
+    xmin(_xmin),
+    ymin(_ymin),
+    xmax(_xmax),
+    ymax(_ymax) {}
+
+    Coord xmin;
+    Coord ymin;
+    Coord xmax;
+    Coord ymax;
+};
+
+/**
+ * @brief       position and number of neighbours for batched nearest neighbour queries
+ */
+template <class Coord = double>
+class QuadTreeKnnQuery {
+public:
+    QuadTreeKnnQuery() :
+    x(0),
+    y(0),
+    k(0) {}
+
+    QuadTreeKnnQuery(Coord _x, Coord _y, unsigned int _k) :
+    x(_x),
+    y(_y),
+    k(_k) {}
+
+    Coord x;
+    Coord y;
+    unsigned int k;
+};
+
+/**
+ * @brief       results of a batch of queries in a single flat buffer
+ *
+ * The results of every query are stored contiguously; the results of query
+ * i (in the order in which the queries were given) start at objects[offsets[i]]
+ * and span counts[i] objects. The buffers keep their capacity between batches.
+ */
+template <class Object>
+class QuadTreeBatchResults {
+public:
+    std::vector<Object> objects;
+    std::vector<size_t> offsets;
+    std::vector<size_t> counts;
+
+    /**
+     * @brief       number of queries in the batch
+     */
+    inline size_t size() const {
+        return this->offsets.size();
+    }
+
+    /**
+     * @brief       number of results of a query
+     */
+    inline size_t count(size_t i) const {
+        return this->counts[i];
+    }
+
+    inline const Object* begin(size_t i) const {
+        return this->objects.data() + this->offsets[i];
+    }
+
+    inline const Object* end(size_t i) const {
+        return this->objects.data() + this->offsets[i] + this->counts[i];
+    }
+};
+
+#endif //_QUAD_TREE_BATCH_QUERY
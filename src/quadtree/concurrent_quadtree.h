@@ -0,0 +1,323 @@
+#ifndef _CONCURRENT_QUAD_TREE
+#define _CONCURRENT_QUAD_TREE
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+#include "quadtree/quadtree.h"
+
+/**
+ * @brief       quadtree supporting lock-free readers alongside a single writer
+ *
+ * The writer modifies a private working tree and makes its changes visible
+ * by calling publish(), which copies the working tree into a new immutable
+ * version and swaps it in atomically (read-copy-update). Readers take a
+ * snapshot of the current version and query it without any locking; a
+ * snapshot remains valid, and unchanged, until it is released.
+ *
+ * Publishing copies the whole tree, so its cost is O(n) in the number of
+ * objects, however little changed. Path copying is not possible, as every
+ * node links back to its parent. Batch the updates between publishes
+ * instead: publish() does nothing when nothing changed, and
+ * publish_batched() only publishes once a minimum number of changes is
+ * pending.
+ *
+ * Replaced versions are retired and only reclaimed once no reader can still
+ * hold them. This is tracked with epochs: every reader owns a slot in which
+ * it announces the epoch it entered at, and a version retired in epoch e is
+ * reclaimed once no slot holds an epoch of e or earlier. The memory of
+ * reclaimed versions is reused for subsequent versions.
+ *
+ * All writer functions must be called from one thread at a time; snapshots
+ * can be taken from any thread that registered as a reader.
+ */
+template <class T, unsigned int Capacity = 4, class Coord = double, unsigned int MaxDepth = 32>
+class ConcurrentQuadTree {
+public:
+    typedef QuadTree<T, Capacity, Coord, MaxDepth> Tree;
+    typedef typename Tree::Object Object;
+
+    static const unsigned int max_readers = 64;
+
+private:
+    /**
+     * @brief       published, immutable state of the tree
+     */
+    class Version {
+    public:
+        Version() :
+        retired(0) {}
+
+        Tree tree;
+        uint64_t retired;   // epoch at which the version was replaced
+    };
+
+    /**
+     * @brief       epoch announced by a reader, padded to its own cache line
+     */
+    class ReaderSlot {
+    public:
+        std::atomic<uint64_t> epoch;    // zero while the reader holds no snapshot
+        std::atomic<bool> used;
+        char padding[64 - sizeof(std::atomic<uint64_t>) - sizeof(std::atomic<bool>)];
+    };
+
+    Tree writer_tree;
+    size_t nr_pending;          // changes to the writer tree since the last publish
+
+    std::atomic<Version*> current;
+    std::atomic<uint64_t> epoch;
+    mutable ReaderSlot slots[max_readers];
+
+    std::vector<Version*> retired_versions;    // replaced versions that may still be in use
+    std::vector<Version*> spare_versions;      // reclaimed versions available for reuse
+
+public:
+    /**
+     * @brief       read-only view of a published version
+     *
+     * Holding a snapshot keeps its version alive; release it (or let it go
+     * out of scope) as soon as possible so that old versions can be reclaimed.
+     */
+    class Snapshot {
+    private:
+        std::atomic<uint64_t>* slot;
+        const Tree* tree;
+
+    public:
+        Snapshot(std::atomic<uint64_t>* _slot, const Tree* _tree) :
+        slot(_slot),
+        tree(_tree) {}
+
+        Snapshot(Snapshot&& other) :
+        slot(other.slot),
+        tree(other.tree) {
+            other.slot = nullptr;
+            other.tree = nullptr;
+        }
+
+        ~Snapshot() {
+            this->release();
+        }
+
+        /**
+         * @brief       end the read-side critical section
+         */
+        void release() {
+            if(this->slot != nullptr) {
+                this->slot->store(0);
+                this->slot = nullptr;
+                this->tree = nullptr;
+            }
+        }
+
+        const Tree* get() const {
+            return this->tree;
+        }
+
+        const Tree* operator->() const {
+            return this->tree;
+        }
+
+        const Tree& operator*() const {
+            return *this->tree;
+        }
+
+    private:
+        Snapshot(Snapshot const&)          = delete;
+        void operator=(Snapshot const&)  = delete;
+    };
+
+    ConcurrentQuadTree(Coord _cx, Coord _cy, Coord _width, Coord _height) :
+        writer_tree(_cx, _cy, _width, _height),
+        nr_pending(0),
+        epoch(1) {
+        for(unsigned int i=0; i<max_readers; i++) {
+            this->slots[i].epoch.store(0);
+            this->slots[i].used.store(false);
+        }
+
+        Version* version = new Version();
+        version->tree.copy_from(this->writer_tree);
+        this->current.store(version);
+    }
+
+    /**
+     * @brief       destroy the tree; no reader may hold a snapshot
+     */
+    ~ConcurrentQuadTree() {
+        delete this->current.load();
+        for(Version* version: this->retired_versions) {
+            delete version;
+        }
+        for(Version* version: this->spare_versions) {
+            delete version;
+        }
+    }
+
+    /**
+     * @brief       claim a reader slot for the calling thread
+     *
+     * @return      slot index, or max_readers when all slots are taken
+     */
+    unsigned int register_reader() {
+        for(unsigned int i=0; i<max_readers; i++) {
+            bool expected = false;
+            if(this->slots[i].used.compare_exchange_strong(expected, true)) {
+                return i;
+            }
+        }
+
+        std::cerr << "Cannot register more than " << max_readers << " quadtree readers" << std::endl;
+        return max_readers;
+    }
+
+    /**
+     * @brief       return a reader slot; the reader may not hold a snapshot
+     */
+    void unregister_reader(unsigned int reader) {
+        if(reader < max_readers) {
+            this->slots[reader].epoch.store(0);
+            this->slots[reader].used.store(false);
+        }
+    }
+
+    /**
+     * @brief       take a snapshot of the most recently published version
+     *
+     * Wait-free: announces the current epoch in the slot of the reader and
+     * loads the current version. A reader holds at most one snapshot at a time.
+     *
+     * @param       reader      slot obtained from register_reader()
+     */
+    Snapshot snapshot(unsigned int reader) const {
+        std::atomic<uint64_t>& slot = this->slots[reader].epoch;
+        slot.store(this->epoch.load());
+        return Snapshot(&slot, &this->current.load()->tree);
+    }
+
+    /**
+     * @brief       tree modified by the writer; changes become visible to readers on publish()
+     *
+     * As the changes made through the returned reference cannot be counted,
+     * it counts as one pending change.
+     */
+    Tree& get_writer_tree() {
+        this->nr_pending++;
+        return this->writer_tree;
+    }
+
+    void add(T* _obj, Coord x, Coord y) {
+        this->writer_tree.add(_obj, x, y);
+        this->nr_pending++;
+    }
+
+    bool remove(T* _obj, Coord x, Coord y) {
+        const bool removed = this->writer_tree.remove(_obj, x, y);
+        this->nr_pending += removed;
+        return removed;
+    }
+
+    bool move(T* _obj, Coord old_x, Coord old_y, Coord new_x, Coord new_y) {
+        const bool moved = this->writer_tree.move(_obj, old_x, old_y, new_x, new_y);
+        this->nr_pending += moved;
+        return moved;
+    }
+
+    /**
+     * @brief       number of changes to the writer tree that are not yet published
+     */
+    size_t get_nr_pending() const {
+        return this->nr_pending;
+    }
+
+    /**
+     * @brief       make the current state of the writer tree visible to readers
+     *
+     * Copies the writer tree into a new version, swaps it in atomically and
+     * retires the previous version. Retired versions that can no longer be
+     * seen by any reader are reclaimed. The copy takes O(n) time, so batch
+     * updates between publishes (see publish_batched()).
+     *
+     * @return      whether a version was published; not the case when nothing changed
+     */
+    bool publish() {
+        if(this->nr_pending == 0) {
+            return false;
+        }
+
+        this->reclaim();
+
+        Version* version = nullptr;
+        if(!this->spare_versions.empty()) {
+            version = this->spare_versions.back();
+            this->spare_versions.pop_back();
+        } else {
+            version = new Version();
+        }
+        version->tree.copy_from(this->writer_tree);
+
+        Version* old = this->current.exchange(version);
+        old->retired = this->epoch.fetch_add(1);
+        this->retired_versions.push_back(old);
+        this->nr_pending = 0;
+
+        this->reclaim();
+
+        return true;
+    }
+
+    /**
+     * @brief       publish once enough changes are pending
+     *
+     * Call after every update to amortize the O(n) cost of publishing over
+     * at least min_changes updates.
+     *
+     * @param       min_changes     number of pending changes required to publish
+     *
+     * @return      whether a version was published
+     */
+    bool publish_batched(size_t min_changes) {
+        return this->nr_pending >= std::max(min_changes, size_t(1)) && this->publish();
+    }
+
+    /**
+     * @brief       number of versions that are retired but not yet reclaimed
+     */
+    size_t get_nr_retired() const {
+        return this->retired_versions.size();
+    }
+
+private:
+    /**
+     * @brief       move the retired versions that no reader can still see to the spare list
+     */
+    void reclaim() {
+        // a reader that announced epoch e may hold any version retired at epoch e or later
+        uint64_t oldest = this->epoch.load();
+        for(unsigned int i=0; i<max_readers; i++) {
+            const uint64_t e = this->slots[i].epoch.load();
+            if(e != 0 && e < oldest) {
+                oldest = e;
+            }
+        }
+
+        size_t nr_kept = 0;
+        for(Version* version: this->retired_versions) {
+            if(version->retired < oldest) {
+                this->spare_versions.push_back(version);
+            } else {
+                this->retired_versions[nr_kept++] = version;
+            }
+        }
+        this->retired_versions.resize(nr_kept);
+    }
+
+    ConcurrentQuadTree(ConcurrentQuadTree const&)          = delete;
+    void operator=(ConcurrentQuadTree const&)  = delete;
+};
+
+#endif //_CONCURRENT_QUAD_TREE
@@ -1,18 +1,25 @@
 #include "field.h"
 
-Field::Field() {
+#include <chrono>
+#include <iostream>
+
+Field::Field() :
+    layout_enabled(true),
+    layout(0.5, -1e-5, 1e-2) {
     this->construct_shader();
     this->construct_objects();
 
-    this->quadtree = QuadTree<Point>(0.5, 0.5, 1, 1);
-
+    std::vector<QuadTreeObject<Point>> objects;
     for(unsigned int i=0; i<50; i++) {
         double x = (double)rand() / (double)RAND_MAX;
         double y = (double)rand() / (double)RAND_MAX;
 
-        this->quadtree.add(new Point(x,y), x, y);
+        this->points.push_back(Point(x,y));
+        objects.push_back(QuadTreeObject<Point>(&this->points.back(), x, y));
     }
 
+    this->quadtree = QuadTree<Point>(0.5, 0.5, 1, 1, objects.data(), objects.size());
+
 }
 
 void Field::draw() {
@@ -25,7 +32,7 @@ void Field::draw() {
     this->shader->set_uniform("mvp", &projection);
     glDrawElements(GL_LINE_LOOP, 4, GL_UNSIGNED_INT, 0);
 
-    this->quadtree.draw(this->shader.get());
+    QuadTreeDraw<QuadTree<Point>>::draw(this->quadtree, this->shader.get());
 
     glBindVertexArray(0);
     this->shader->unlink_shader();
@@ -61,5 +68,110 @@ void Field::construct_objects() {
 }
 
 void Field::add_point(double x, double y) {
-    this->quadtree.add(new Point(x,y), x, y);
+    this->points.push_back(Point(x,y));
+    this->quadtree.add(&this->points.back(), x, y);
+}
+
+bool Field::load_points(const std::string& filename) {
+    PointReader reader;
+    const auto start = std::chrono::steady_clock::now();
+    if(!reader.open(filename)) {
+        return false;
+    }
+
+    this->points.clear();
+    this->quadtree.clear();
+    this->layout_enabled = false;
+
+    // index every chunk as it arrives while the reader parses the next
+    // ones; only the objects of one chunk are kept besides the points
+    const QuadTree<Point>::Node* root = this->quadtree.get_root();
+    PointChunk chunk;
+    std::vector<QuadTreeObject<Point>> objects;
+    size_t nr_rejected = 0;
+    double t_build = 0.0;
+    while(reader.read_chunk(chunk)) {
+        objects.clear();
+        for(size_t i=0; i<chunk.size(); i++) {
+            const Point point(chunk.x[i], chunk.y[i]);
+            if(!root->contains(point.x, point.y)) {
+                nr_rejected++;
+                continue;
+            }
+            this->points.push_back(point);
+            objects.push_back(QuadTreeObject<Point>(&this->points.back(), point.x, point.y));
+        }
+
+        const auto build_start = std::chrono::steady_clock::now();
+        this->quadtree.bulk_load(objects.data(), objects.size());
+        t_build += std::chrono::duration<double>(std::chrono::steady_clock::now() - build_start).count();
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t nr_points = reader.get_nr_points();
+    std::cout << "Loaded " << nr_points << " points (" << reader.get_nr_bytes() << " bytes) from " << filename
+              << " in " << elapsed << " s (" << elapsed - t_build << " s reading, " << t_build << " s building): "
+              << (elapsed > 0 ? nr_points / elapsed : 0.0) << " points/s" << std::endl;
+    if(reader.get_nr_skipped() != 0) {
+        std::cout << "Skipped " << reader.get_nr_skipped() << " lines without a point" << std::endl;
+    }
+    if(nr_rejected != 0) {
+        std::cout << "Skipped " << nr_rejected << " points outside the field" << std::endl;
+    }
+
+    this->quadtree.get_statistics().print(std::cout);
+
+    return !reader.has_failed();
+}
+
+QuadTreeStatistics Field::get_statistics(bool detailed) const {
+    return this->quadtree.get_statistics(detailed);
+}
+
+bool Field::pick_point(double x, double y) {
+    static const double pick_radius = 0.01;
+
+    std::vector<QuadTreeObject<Point>> hits;
+    this->quadtree.query_knn(x, y, 1, hits);
+    if(hits.empty()) {
+        return false;
+    }
+
+    const QuadTreeObject<Point>& hit = hits.front();
+    if((hit.x - x) * (hit.x - x) + (hit.y - y) * (hit.y - y) > pick_radius * pick_radius) {
+        return false;
+    }
+
+    return this->quadtree.remove(hit.objptr, hit.x, hit.y);
+}
+
+void Field::update(double dt) {
+    static const double centering = 0.5;
+
+    if(!this->layout_enabled) {
+        return;
+    }
+
+    this->layout_objects.clear();
+    this->quadtree.get_root()->collect(this->layout_objects);
+
+    const size_t n = this->layout_objects.size();
+    this->layout_fx.resize(n);
+    this->layout_fy.resize(n);
+    this->layout.evaluate_all(this->quadtree, this->layout_objects.data(), n, this->layout_fx.data(), this->layout_fy.data());
+
+    // overdamped motion: the displacement follows the force
+    for(size_t i=0; i<n; i++) {
+        const QuadTreeObject<Point>& obj = this->layout_objects[i];
+        const double fx = this->layout_fx[i] + centering * (0.5 - obj.x);
+        const double fy = this->layout_fy[i] + centering * (0.5 - obj.y);
+        // keep the points inside the root, which includes its upper edges
+        const float x = std::min(std::max(obj.x + fx * dt, 0.0), 1.0);
+        const float y = std::min(std::max(obj.y + fy * dt, 0.0), 1.0);
+
+        if(this->quadtree.move(obj.objptr, obj.x, obj.y, x, y)) {
+            obj.objptr->x = x;
+            obj.objptr->y = y;
+        }
+    }
 }
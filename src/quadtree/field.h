@@ -2,10 +2,14 @@
 #define _FIELD_H
 
 #include <stdlib.h>
+#include <deque>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include "core/shader.h"
 #include "quadtree.h"
+#include "barnes_hut.h"
+#include "point_reader.h"
+#include "quadtree_draw.h"
 
 class Point {
 public:
@@ -20,9 +24,16 @@ private:
     GLuint vao;
     GLuint vbo[2];
     std::unique_ptr<Shader> shader;
-    std::vector<Point> points;
+    std::deque<Point> points;   // owns the points; a deque keeps their addresses stable
     QuadTree<Point> quadtree;
 
+    // force-directed layout of the points
+    bool layout_enabled;
+    QuadTreeBarnesHut<QuadTree<Point>> layout;
+    std::vector<QuadTreeObject<Point>> layout_objects;
+    std::vector<double> layout_fx;
+    std::vector<double> layout_fy;
+
 public:
 
     /**
@@ -37,6 +48,56 @@ public:
 
     void add_point(double x, double y);
 
+    /**
+     * @brief       replace the points by those read from a file
+     *
+     * The file is parsed in chunks on a background thread (see PointReader)
+     * while every chunk already parsed is merged into the quadtree with
+     * bulk_load(), such that only one chunk of objects is held besides the
+     * points themselves. Points outside the unit square of the field are
+     * skipped and counted.
+     *
+     * @param       filename    CSV (x,y per line) or raw .f32 / .f64 point file
+     *
+     * @return      whether the file was read completely
+     */
+    bool load_points(const std::string& filename);
+
+    /**
+     * @brief       advance the layout of the points by one time step
+     *
+     * The points repel each other (evaluated with the Barnes-Hut
+     * approximation) and are pulled towards the center of the field. The
+     * layout only runs while enabled (see toggle_layout()).
+     *
+     * @param       dt          time step
+     */
+    void update(double dt);
+
+    /**
+     * @brief       switch the force-directed layout on or off
+     *
+     * The layout is on for the random demo points and switched off when
+     * points are loaded from a file, such that those keep their positions.
+     */
+    inline void toggle_layout() {
+        this->layout_enabled = !this->layout_enabled;
+    }
+
+    /**
+     * @brief       remove the point nearest to a position, if it lies within the pick radius
+     *
+     * @return      whether a point was hit
+     */
+    bool pick_point(double x, double y);
+
+    /**
+     * @brief       get the shape and memory use of the quadtree
+     *
+     * @param       detailed    whether to include the histograms, which requires a traversal
+     */
+    QuadTreeStatistics get_statistics(bool detailed = false) const;
+
     void draw();
 
 private:
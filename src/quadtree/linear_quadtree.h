@@ -0,0 +1,654 @@
+#ifndef _LINEAR_QUAD_TREE
+#define _LINEAR_QUAD_TREE
+
+#include <vector>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+
+#include "quadtree/quadtree.h"
+#include "quadtree/morton.h"
+
+/**
+ * @brief       implicit node of a linear quadtree
+ *
+ * A node is identified by its level and its integer position on the grid of
+ * that level. Its objects occupy the index range [begin, end) of the sorted
+ * object array.
+ */
+class LinearQuadTreeCell {
+public:
+    LinearQuadTreeCell() :
+        level(0),
+        ix(0),
+        iy(0),
+        begin(0),
+        end(0) {}
+
+    LinearQuadTreeCell(unsigned int _level, uint32_t _ix, uint32_t _iy, size_t _begin, size_t _end) :
+        level(_level),
+        ix(_ix),
+        iy(_iy),
+        begin(_begin),
+        end(_end) {}
+
+    unsigned int level;
+    uint32_t ix;
+    uint32_t iy;
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * @brief       working storage for nearest neighbour queries on a linear quadtree
+ */
+template <class T>
+class LinearQuadTreeKnnScratch {
+public:
+    std::vector<std::pair<double, LinearQuadTreeCell>> nodes;   // min-heap of nodes to visit
+    std::vector<std::pair<double, QuadTreeObject<T>>> best;     // max-heap of the k best objects
+};
+
+/**
+ * @brief       pointerless quadtree storing its objects sorted on Morton code
+ *
+ * Offers the same interface as QuadTree. Positions are quantized on a grid
+ * of 2^32 x 2^32 cells spanning the bounding box and the objects are kept in
+ * a contiguous array sorted on the Morton code of their grid cell. Nodes are
+ * not stored: the objects of any node form a contiguous range of the array,
+ * which is located by binary search on the keys. A node is a leaf when it
+ * holds no more than Capacity objects, matching QuadTree.
+ *
+ * Added (and moved) objects are buffered until flush() merges them into the
+ * sorted array. Queries on a non-const tree flush first, as QuadTree sees
+ * added objects immediately. Const queries do not modify the tree, such that
+ * several threads can query a flushed tree concurrently through a const
+ * reference; a const query with objects still buffered would miss them and
+ * therefore aborts the program in every build type.
+ *
+ * @tparam      T           type of the indexed objects
+ * @tparam      Capacity    maximum number of objects in a leaf
+ */
+template <class T, unsigned int Capacity = 4>
+class LinearQuadTree {
+private:
+    static const unsigned int max_level = 32;
+
+    double xmin;
+    double ymin;
+    double width;
+    double height;
+    double scale_x;         // grid cells per unit length in x direction
+    double scale_y;         // grid cells per unit length in y direction
+    bool initialized;
+
+    std::vector<uint64_t> keys;                                     // sorted Morton codes
+    std::vector<QuadTreeObject<T>> objects;                         // objects in key order
+    std::vector<std::pair<uint64_t, QuadTreeObject<T>>> pending;    // objects not yet merged
+    std::vector<std::pair<uint64_t, QuadTreeObject<T>>> sort_buffer;
+    std::vector<uint64_t> merge_keys;
+    std::vector<QuadTreeObject<T>> merge_objects;
+
+public:
+    LinearQuadTree() :
+        xmin(0.0),
+        ymin(0.0),
+        width(0.0),
+        height(0.0),
+        scale_x(0.0),
+        scale_y(0.0),
+        initialized(false) {}
+
+    LinearQuadTree(double _cx, double _cy, double _width, double _height) :
+        xmin(_cx - _width / 2.0),
+        ymin(_cy - _height / 2.0),
+        width(_width),
+        height(_height),
+        scale_x(4294967296.0 / _width),
+        scale_y(4294967296.0 / _height),
+        initialized(true) {}
+
+    LinearQuadTree(LinearQuadTree&&) = default;
+    LinearQuadTree& operator=(LinearQuadTree&&) = default;
+
+    /**
+     * @brief       construct a linear quadtree from an array of objects in one pass
+     */
+    LinearQuadTree(double _cx, double _cy, double _width, double _height, const QuadTreeObject<T>* objs, size_t nr_objs) :
+        LinearQuadTree(_cx, _cy, _width, _height) {
+        this->bulk_load(objs, nr_objs);
+    }
+
+    /**
+     * @brief       queue an object for insertion; it becomes visible after flush()
+     */
+    void add(T* _obj, double x, double y) {
+        if(!this->initialized) {
+            std::cerr << "Cannot add objects to quadtree with NULL root" << std::endl;
+            return;
+        }
+
+        if(!this->contains(x, y)) {
+            std::cerr << "Cannot add object outside the quadtree bounding box" << std::endl;
+            return;
+        }
+
+        this->pending.push_back(std::make_pair(this->key(x, y), QuadTreeObject<T>(_obj, x, y)));
+    }
+
+    /**
+     * @brief       insert an array of objects in one pass
+     */
+    void bulk_load(const QuadTreeObject<T>* objs, size_t nr_objs) {
+        this->pending.reserve(this->pending.size() + nr_objs);
+        for(size_t i=0; i<nr_objs; i++) {
+            this->add(objs[i].objptr, objs[i].x, objs[i].y);
+        }
+        this->flush();
+
+        // the staging buffers are as large as the tree; do not keep them
+        this->pending.shrink_to_fit();
+        this->sort_buffer = std::vector<std::pair<uint64_t, QuadTreeObject<T>>>();
+    }
+
+    /**
+     * @brief       remove all objects
+     *
+     * @param       keep_memory     whether to keep the memory for reuse
+     */
+    void clear(bool keep_memory = true) {
+        this->keys.clear();
+        this->objects.clear();
+        this->pending.clear();
+
+        if(!keep_memory) {
+            this->keys.shrink_to_fit();
+            this->objects.shrink_to_fit();
+            this->pending.shrink_to_fit();
+            this->sort_buffer = std::vector<std::pair<uint64_t, QuadTreeObject<T>>>();
+            this->merge_keys = std::vector<uint64_t>();
+            this->merge_objects = std::vector<QuadTreeObject<T>>();
+        }
+    }
+
+    /**
+     * @brief       remove an object
+     *
+     * @param       _obj        pointer to the object
+     * @param       x           x position under which the object was added
+     * @param       y           y position under which the object was added
+     * @param       reclaimed   if not null, set to zero (nodes are implicit)
+     *
+     * The object is erased from the sorted arrays, which shifts all objects
+     * behind it and thus takes time linear in the size of the tree.
+     *
+     * @return      whether the object was found
+     */
+    bool remove(T* _obj, double x, double y, unsigned int* reclaimed = nullptr) {
+        if(reclaimed != nullptr) {
+            *reclaimed = 0;
+        }
+
+        const size_t idx = this->find(_obj, x, y);
+        if(idx == this->objects.size()) {
+            return false;
+        }
+
+        this->keys.erase(this->keys.begin() + idx);
+        this->objects.erase(this->objects.begin() + idx);
+        return true;
+    }
+
+    /**
+     * @brief       move an object to a new position
+     *
+     * When the object stays in the same grid cell, only its coordinates are
+     * updated; otherwise it is removed and queued for reinsertion, after
+     * which it becomes visible again with flush(). Like remove(), leaving
+     * the cell takes time linear in the size of the tree.
+     *
+     * @return      whether the object was found and moved
+     */
+    bool move(T* _obj, double old_x, double old_y, double new_x, double new_y) {
+        if(!this->contains(new_x, new_y)) {
+            std::cerr << "Cannot move object outside the quadtree bounding box" << std::endl;
+            return false;
+        }
+
+        const size_t idx = this->find(_obj, old_x, old_y);
+        if(idx == this->objects.size()) {
+            return false;
+        }
+
+        const uint64_t new_key = this->key(new_x, new_y);
+        if(new_key == this->keys[idx]) {
+            this->objects[idx].x = new_x;
+            this->objects[idx].y = new_y;
+            return true;
+        }
+
+        this->keys.erase(this->keys.begin() + idx);
+        this->objects.erase(this->objects.begin() + idx);
+        this->pending.push_back(std::make_pair(new_key, QuadTreeObject<T>(_obj, new_x, new_y)));
+        return true;
+    }
+
+    /**
+     * @brief       merge any buffered objects, then find all objects inside an axis-aligned rectangle
+     */
+    void query_range(double qxmin, double qymin, double qxmax, double qymax, std::vector<QuadTreeObject<T>>& results) {
+        this->flush();
+        static_cast<const LinearQuadTree&>(*this).query_range(qxmin, qymin, qxmax, qymax, results);
+    }
+
+    /**
+     * @brief       find all objects inside an axis-aligned rectangle
+     */
+    void query_range(double qxmin, double qymin, double qxmax, double qymax, std::vector<QuadTreeObject<T>>& results) const {
+        this->check_flushed();
+        this->traverse([&](const LinearQuadTreeCell& cell) -> bool {
+            double bxmin, bymin, bxmax, bymax;
+            this->get_box(cell, bxmin, bymin, bxmax, bymax);
+
+            if(bxmin > qxmax || bxmax < qxmin || bymin > qymax || bymax < qymin) {
+                return false;
+            }
+
+            if(bxmin >= qxmin && bxmax <= qxmax && bymin >= qymin && bymax <= qymax) {
+                results.insert(results.end(), this->objects.begin() + cell.begin, this->objects.begin() + cell.end);
+                return false;
+            }
+
+            if(this->is_leaf(cell)) {
+                for(size_t i=cell.begin; i<cell.end; i++) {
+                    const QuadTreeObject<T>& obj = this->objects[i];
+                    if(obj.x >= qxmin && obj.x <= qxmax && obj.y >= qymin && obj.y <= qymax) {
+                        results.push_back(obj);
+                    }
+                }
+                return false;
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       merge any buffered objects, then find all objects within a distance of a position
+     */
+    void query_radius(double x, double y, double r, std::vector<QuadTreeObject<T>>& results) {
+        this->flush();
+        static_cast<const LinearQuadTree&>(*this).query_radius(x, y, r, results);
+    }
+
+    /**
+     * @brief       find all objects within a distance of a position
+     */
+    void query_radius(double x, double y, double r, std::vector<QuadTreeObject<T>>& results) const {
+        this->check_flushed();
+        const double r2 = r * r;
+        this->traverse([&](const LinearQuadTreeCell& cell) -> bool {
+            double bxmin, bymin, bxmax, bymax;
+            this->get_box(cell, bxmin, bymin, bxmax, bymax);
+
+            const double dxmin = std::max(std::max(bxmin - x, x - bxmax), 0.0);
+            const double dymin = std::max(std::max(bymin - y, y - bymax), 0.0);
+            if(dxmin * dxmin + dymin * dymin > r2) {
+                return false;
+            }
+
+            const double dxmax = std::max(x - bxmin, bxmax - x);
+            const double dymax = std::max(y - bymin, bymax - y);
+            if(dxmax * dxmax + dymax * dymax <= r2) {
+                results.insert(results.end(), this->objects.begin() + cell.begin, this->objects.begin() + cell.end);
+                return false;
+            }
+
+            if(this->is_leaf(cell)) {
+                for(size_t i=cell.begin; i<cell.end; i++) {
+                    const QuadTreeObject<T>& obj = this->objects[i];
+                    const double dx = obj.x - x;
+                    const double dy = obj.y - y;
+                    if(dx * dx + dy * dy <= r2) {
+                        results.push_back(obj);
+                    }
+                }
+                return false;
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       merge any buffered objects, then find the k objects closest to a position
+     */
+    void query_knn(double x, double y, unsigned int k, std::vector<QuadTreeObject<T>>& results) {
+        this->flush();
+        static_cast<const LinearQuadTree&>(*this).query_knn(x, y, k, results);
+    }
+
+    /**
+     * @brief       merge any buffered objects, then find the k objects closest to a position using external working storage
+     */
+    void query_knn(double x, double y, unsigned int k, std::vector<QuadTreeObject<T>>& results, LinearQuadTreeKnnScratch<T>& scratch) {
+        this->flush();
+        static_cast<const LinearQuadTree&>(*this).query_knn(x, y, k, results, scratch);
+    }
+
+    /**
+     * @brief       find the k objects closest to a position
+     */
+    void query_knn(double x, double y, unsigned int k, std::vector<QuadTreeObject<T>>& results) const {
+        // one scratch per thread, such that concurrent const queries do not share storage
+        static thread_local LinearQuadTreeKnnScratch<T> scratch;
+        this->query_knn(x, y, k, results, scratch);
+    }
+
+    /**
+     * @brief       find the k objects closest to a position using external working storage
+     */
+    void query_knn(double x, double y, unsigned int k, std::vector<QuadTreeObject<T>>& results, LinearQuadTreeKnnScratch<T>& scratch) const {
+        typedef std::pair<double, LinearQuadTreeCell> NodeEntry;
+        typedef std::pair<double, QuadTreeObject<T>> ObjectEntry;
+
+        static const auto node_cmp = [](const NodeEntry& a, const NodeEntry& b) {
+            return a.first > b.first;
+        };
+        static const auto obj_cmp = [](const ObjectEntry& a, const ObjectEntry& b) {
+            return a.first < b.first;
+        };
+
+        results.clear();
+        this->check_flushed();
+        if(this->objects.empty() || k == 0) {
+            return;
+        }
+
+        auto& nodes = scratch.nodes;
+        auto& best = scratch.best;
+        nodes.clear();
+        best.clear();
+
+        nodes.push_back(NodeEntry(0.0, this->root_cell()));
+
+        while(!nodes.empty()) {
+            std::pop_heap(nodes.begin(), nodes.end(), node_cmp);
+            const NodeEntry entry = nodes.back();
+            nodes.pop_back();
+
+            if(best.size() == k && entry.first >= best.front().first) {
+                break;
+            }
+
+            const LinearQuadTreeCell& cell = entry.second;
+            if(this->is_leaf(cell)) {
+                for(size_t i=cell.begin; i<cell.end; i++) {
+                    const QuadTreeObject<T>& obj = this->objects[i];
+                    const double d2 = (obj.x - x) * (obj.x - x) + (obj.y - y) * (obj.y - y);
+
+                    if(best.size() < k) {
+                        best.push_back(ObjectEntry(d2, obj));
+                        std::push_heap(best.begin(), best.end(), obj_cmp);
+                    } else if(d2 < best.front().first) {
+                        std::pop_heap(best.begin(), best.end(), obj_cmp);
+                        best.back() = ObjectEntry(d2, obj);
+                        std::push_heap(best.begin(), best.end(), obj_cmp);
+                    }
+                }
+                continue;
+            }
+
+            LinearQuadTreeCell children[4];
+            this->split_cell(cell, children);
+            for(unsigned int i=0; i<4; i++) {
+                if(children[i].begin == children[i].end) {
+                    continue;
+                }
+                const double d2 = this->min_distance2(children[i], x, y);
+                if(best.size() < k || d2 < best.front().first) {
+                    nodes.push_back(NodeEntry(d2, children[i]));
+                    std::push_heap(nodes.begin(), nodes.end(), node_cmp);
+                }
+            }
+        }
+
+        std::sort_heap(best.begin(), best.end(), obj_cmp);
+        for(const auto& entry: best) {
+            results.push_back(entry.second);
+        }
+    }
+
+    /**
+     * @brief       merge the buffered objects into the sorted array
+     *
+     * Non-const queries call this themselves; it must be called after add()
+     * or move() before the tree is queried through a const reference.
+     */
+    void flush() {
+        if(this->pending.empty()) {
+            return;
+        }
+
+        morton_radix_sort(this->pending, this->sort_buffer, 64);
+
+        if(this->keys.empty()) {
+            this->keys.resize(this->pending.size());
+            this->objects.resize(this->pending.size());
+            for(size_t i=0; i<this->pending.size(); i++) {
+                this->keys[i] = this->pending[i].first;
+                this->objects[i] = this->pending[i].second;
+            }
+            this->pending.clear();
+            return;
+        }
+
+        this->merge_keys.resize(this->keys.size() + this->pending.size());
+        this->merge_objects.resize(this->objects.size() + this->pending.size());
+
+        size_t i = 0;
+        size_t j = 0;
+        size_t n = 0;
+        while(i < this->keys.size() || j < this->pending.size()) {
+            if(j == this->pending.size() || (i < this->keys.size() && this->keys[i] <= this->pending[j].first)) {
+                this->merge_keys[n] = this->keys[i];
+                this->merge_objects[n] = this->objects[i];
+                i++;
+            } else {
+                this->merge_keys[n] = this->pending[j].first;
+                this->merge_objects[n] = this->pending[j].second;
+                j++;
+            }
+            n++;
+        }
+
+        this->keys.swap(this->merge_keys);
+        this->objects.swap(this->merge_objects);
+        this->pending.clear();
+    }
+
+    void print() const {
+        this->check_flushed();
+        this->traverse([this](const LinearQuadTreeCell& cell) -> bool {
+            const double cw = std::ldexp(this->width, -int(cell.level));
+            const double ch = std::ldexp(this->height, -int(cell.level));
+            std::cout << "NODE: " << this->xmin + (cell.ix + 0.5) * cw << "\t" << this->ymin + (cell.iy + 0.5) * ch << "\t" << cell.level << std::endl;
+
+            if(this->is_leaf(cell)) {
+                for(size_t i=cell.begin; i<cell.end; i++) {
+                    std::cout << this->objects[i].x << "\t" << this->objects[i].y << "\t" << this->objects[i].objptr << std::endl;
+                }
+            }
+            return true;
+        });
+    }
+
+    /**
+     * @brief       number of objects stored
+     */
+    size_t size() const {
+        return this->objects.size() + this->pending.size();
+    }
+
+    /**
+     * @brief       number of bytes allocated for the tree
+     */
+    size_t get_memory_usage() const {
+        return sizeof(*this) +
+               this->keys.capacity() * sizeof(uint64_t) +
+               this->objects.capacity() * sizeof(QuadTreeObject<T>) +
+               this->pending.capacity() * sizeof(std::pair<uint64_t, QuadTreeObject<T>>) +
+               this->sort_buffer.capacity() * sizeof(std::pair<uint64_t, QuadTreeObject<T>>) +
+               this->merge_keys.capacity() * sizeof(uint64_t) +
+               this->merge_objects.capacity() * sizeof(QuadTreeObject<T>);
+    }
+
+private:
+    /**
+     * @brief       abort when objects are buffered, as a const query cannot see them
+     */
+    inline void check_flushed() const {
+        if(!this->pending.empty()) {
+            std::cerr << "Cannot query linear quadtree with " << this->pending.size() << " objects pending; call flush() first" << std::endl;
+            std::abort();
+        }
+    }
+
+    inline bool contains(double x, double y) const {
+        return x >= this->xmin && x <= this->xmin + this->width &&
+               y >= this->ymin && y <= this->ymin + this->height;
+    }
+
+    inline static uint32_t quantize(double v, double vmin, double scale) {
+        const double f = (v - vmin) * scale;
+        if(f <= 0.0) {
+            return 0;
+        }
+        if(f >= 4294967295.0) {
+            return 0xFFFFFFFF;
+        }
+        return uint32_t(f);
+    }
+
+    inline uint64_t key(double x, double y) const {
+        return morton_encode(quantize(x, this->xmin, this->scale_x), quantize(y, this->ymin, this->scale_y));
+    }
+
+    inline LinearQuadTreeCell root_cell() const {
+        return LinearQuadTreeCell(0, 0, 0, 0, this->objects.size());
+    }
+
+    inline bool is_leaf(const LinearQuadTreeCell& cell) const {
+        return cell.end - cell.begin <= Capacity || cell.level == max_level;
+    }
+
+    /**
+     * @brief       get the bounding box of a node
+     *
+     * The box is widened by two grid cells to absorb rounding in the
+     * quantization, such that pruning on it never rejects a stored object.
+     */
+    inline void get_box(const LinearQuadTreeCell& cell, double& bxmin, double& bymin, double& bxmax, double& bymax) const {
+        const double cw = std::ldexp(this->width, -int(cell.level));
+        const double ch = std::ldexp(this->height, -int(cell.level));
+        const double mx = 2.0 / this->scale_x;
+        const double my = 2.0 / this->scale_y;
+        bxmin = this->xmin + cell.ix * cw - mx;
+        bymin = this->ymin + cell.iy * ch - my;
+        bxmax = this->xmin + (cell.ix + 1.0) * cw + mx;
+        bymax = this->ymin + (cell.iy + 1.0) * ch + my;
+    }
+
+    inline double min_distance2(const LinearQuadTreeCell& cell, double x, double y) const {
+        double bxmin, bymin, bxmax, bymax;
+        this->get_box(cell, bxmin, bymin, bxmax, bymax);
+        const double dx = std::max(std::max(bxmin - x, x - bxmax), 0.0);
+        const double dy = std::max(std::max(bymin - y, y - bymax), 0.0);
+        return dx * dx + dy * dy;
+    }
+
+    /**
+     * @brief       locate the object ranges of the four children of a node
+     *
+     * The children of a node partition its key range into four consecutive
+     * ranges; their boundaries are found by binary search.
+     */
+    void split_cell(const LinearQuadTreeCell& cell, LinearQuadTreeCell* children) const {
+        const unsigned int shift = 62 - 2 * cell.level;
+        const uint64_t base = (cell.level == 0) ? 0 : (this->keys[cell.begin] >> (shift + 2)) << (shift + 2);
+
+        size_t bounds[5];
+        bounds[0] = cell.begin;
+        bounds[4] = cell.end;
+        for(unsigned int i=1; i<4; i++) {
+            bounds[i] = std::lower_bound(this->keys.begin() + bounds[i-1], this->keys.begin() + cell.end, base | (uint64_t(i) << shift)) - this->keys.begin();
+        }
+
+        for(unsigned int i=0; i<4; i++) {
+            children[i] = LinearQuadTreeCell(cell.level + 1, cell.ix * 2 + (i & 1), cell.iy * 2 + (i >> 1), bounds[i], bounds[i+1]);
+        }
+    }
+
+    /**
+     * @brief       visit cells top-down, skipping the subtrees of rejected cells
+     *
+     * Non-recursive like QuadTreeTraversal: while a cell at level l is
+     * expanded, the stack holds at most three unvisited siblings for every
+     * level above it plus its four children. Empty cells are not visited and
+     * leaves are never expanded.
+     *
+     * @param       visit       callable taking a cell and returning whether to descend into it
+     */
+    template <class Visitor>
+    void traverse(Visitor visit) const {
+        if(this->objects.empty()) {
+            return;
+        }
+
+        LinearQuadTreeCell stack[3 * max_level + 4];
+        unsigned int top = 0;
+        stack[top++] = this->root_cell();
+
+        while(top != 0) {
+            const LinearQuadTreeCell cell = stack[--top];
+            if(!visit(cell) || this->is_leaf(cell)) {
+                continue;
+            }
+
+            LinearQuadTreeCell children[4];
+            this->split_cell(cell, children);
+            for(unsigned int i=4; i>0; i--) {
+                if(children[i-1].begin != children[i-1].end) {
+                    stack[top++] = children[i-1];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief       locate an object in the sorted array
+     *
+     * @return      index of the object or the number of objects when absent
+     */
+    size_t find(T* _obj, double x, double y) {
+        this->flush();
+
+        const uint64_t k = this->key(x, y);
+        const auto range = std::equal_range(this->keys.begin(), this->keys.end(), k);
+        for(auto it = range.first; it != range.second; ++it) {
+            const size_t idx = it - this->keys.begin();
+            if(this->objects[idx].objptr == _obj) {
+                return idx;
+            }
+        }
+        return this->objects.size();
+    }
+
+    LinearQuadTree(LinearQuadTree const&)          = delete;
+    void operator=(LinearQuadTree const&)  = delete;
+};
+
+#endif //_LINEAR_QUAD_TREE
@@ -0,0 +1,735 @@
+#ifndef _LOOSE_QUAD_TREE
+#define _LOOSE_QUAD_TREE
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <new>
+
+#include "quadtree/node_pool.h"
+#include "quadtree/traversal.h"
+
+/**
+ * @brief       object with an axis-aligned bounding box
+ */
+template <class T, class Coord = double>
+class LooseQuadTreeObject {
+public:
+    LooseQuadTreeObject() :
+    objptr(nullptr),
+    xmin(0),
+    ymin(0),
+    xmax(0),
+    ymax(0) {}
+
+    LooseQuadTreeObject(T* _objptr, Coord _xmin, Coord _ymin, Coord _xmax, Coord _ymax) :
+    objptr(_objptr),
+    xmin(_xmin),
+    ymin(_ymin),
+    xmax(_xmax),
+    ymax(_ymax) {}
+
+    T* objptr;
+    Coord xmin;
+    Coord ymin;
+    Coord xmax;
+    Coord ymax;
+};
+
+/**
+ * @brief       node of a LooseQuadTree
+ *
+ * Besides its (tight) box, which partitions the plane like the nodes of
+ * QuadTree, every node has loose bounds: the tight box scaled by
+ * the looseness of the tree around the same center. An object is stored in
+ * a node only when its bounding box lies within the loose bounds of that
+ * node. The objects themselves live in the entry array of the tree; a node
+ * only holds the head of its linked list of entries.
+ *
+ * @tparam      Coord       coordinate type
+ * @tparam      MaxDepth    level at which nodes are no longer split
+ */
+template <class Coord = double, unsigned int MaxDepth = 32>
+class LooseQuadTreeNode {
+public:
+    typedef QuadTreeNodePool<LooseQuadTreeNode> Pool;
+    typedef Coord coord_type;
+
+    static const unsigned int max_depth = MaxDepth;
+    static const unsigned int nil = ~0u;
+
+private:
+    LooseQuadTreeNode* parent;
+    LooseQuadTreeNode* children[4];
+
+    Coord cx;  // center x position
+    Coord cy;  // center y position
+
+    Coord width;   // bounding box width
+    Coord height;  // bounding box height
+
+    // loose bounds, which hold every object stored in this node
+    Coord loose_xmin;
+    Coord loose_xmax;
+    Coord loose_ymin;
+    Coord loose_ymax;
+
+    unsigned int first;         // first entry of the object list
+    unsigned int nr_objects;    // number of objects stored in this node
+
+    unsigned int level;
+
+public:
+    LooseQuadTreeNode(Coord _cx, Coord _cy, Coord _width, Coord _height, Coord _looseness, unsigned int _level, LooseQuadTreeNode* _parent):
+        parent(_parent),
+        cx(_cx),
+        cy(_cy),
+        width(_width),
+        height(_height),
+        loose_xmin(_cx - _looseness * _width / Coord(2)),
+        loose_xmax(_cx + _looseness * _width / Coord(2)),
+        loose_ymin(_cy - _looseness * _height / Coord(2)),
+        loose_ymax(_cy + _looseness * _height / Coord(2)),
+        first(nil),
+        nr_objects(0),
+        level(_level) {
+            this->children[0] = nullptr;
+            this->children[1] = nullptr;
+            this->children[2] = nullptr;
+            this->children[3] = nullptr;
+        }
+
+    inline bool has_children() const {
+        return (this->children[0] != nullptr);
+    }
+
+    /**
+     * @brief       get the index of the child quadrant that holds a position
+     *
+     * Uses the same Morton order as QuadTreeNode::quadrant().
+     *
+     * @return      child index (0-3)
+     */
+    inline unsigned int quadrant(Coord x, Coord y) const {
+        return (x >= this->cx ? 1 : 0) | (y >= this->cy ? 2 : 0);
+    }
+
+    inline const LooseQuadTreeNode* get_child(unsigned int i) const {
+        return this->children[i];
+    }
+
+    inline LooseQuadTreeNode* get_child(unsigned int i) {
+        return this->children[i];
+    }
+
+    inline LooseQuadTreeNode* get_parent() {
+        return this->parent;
+    }
+
+    inline const LooseQuadTreeNode* get_parent() const {
+        return this->parent;
+    }
+
+    inline unsigned int get_first() const {
+        return this->first;
+    }
+
+    inline void set_first(unsigned int _first) {
+        this->first = _first;
+    }
+
+    /**
+     * @brief       number of objects stored in this node (excluding its descendants)
+     */
+    inline unsigned int get_nr_objects() const {
+        return this->nr_objects;
+    }
+
+    inline void set_nr_objects(unsigned int _nr_objects) {
+        this->nr_objects = _nr_objects;
+    }
+
+    inline unsigned int get_level() const {
+        return this->level;
+    }
+
+    inline Coord get_cx() const {
+        return this->cx;
+    }
+
+    inline Coord get_cy() const {
+        return this->cy;
+    }
+
+    inline Coord get_width() const {
+        return this->width;
+    }
+
+    inline Coord get_height() const {
+        return this->height;
+    }
+
+    inline Coord get_loose_xmin() const {
+        return this->loose_xmin;
+    }
+
+    inline Coord get_loose_xmax() const {
+        return this->loose_xmax;
+    }
+
+    inline Coord get_loose_ymin() const {
+        return this->loose_ymin;
+    }
+
+    inline Coord get_loose_ymax() const {
+        return this->loose_ymax;
+    }
+
+    /**
+     * @brief       check whether a box lies within the loose bounds
+     */
+    inline bool encloses(Coord bxmin, Coord bymin, Coord bxmax, Coord bymax) const {
+        return bxmin >= this->loose_xmin && bxmax <= this->loose_xmax &&
+               bymin >= this->loose_ymin && bymax <= this->loose_ymax;
+    }
+
+    /**
+     * @brief       check whether a box overlaps with the loose bounds
+     */
+    inline bool overlaps(Coord bxmin, Coord bymin, Coord bxmax, Coord bymax) const {
+        return bxmin <= this->loose_xmax && bxmax >= this->loose_xmin &&
+               bymin <= this->loose_ymax && bymax >= this->loose_ymin;
+    }
+
+    /**
+     * @brief       create the four children (in the order given by quadrant()) in a single block
+     */
+    void split(Coord looseness, Pool& pool) {
+        if(this->has_children()) {
+            return;
+        }
+
+        const Coord new_width = this->width / Coord(2);
+        const Coord new_height = this->height / Coord(2);
+
+        LooseQuadTreeNode* block = pool.allocate_block();
+        for(unsigned int i=0; i<4; i++) {
+            const Coord ccx = (i & 1) ? this->cx + new_width / Coord(2) : this->cx - new_width / Coord(2);
+            const Coord ccy = (i & 2) ? this->cy + new_height / Coord(2) : this->cy - new_height / Coord(2);
+            this->children[i] = new(block + i) LooseQuadTreeNode(ccx, ccy, new_width, new_height, looseness, this->level+1, this);
+        }
+    }
+
+    /**
+     * @brief       discard the (leaf) children of this node
+     */
+    void release_children(Pool& pool) {
+        // the four siblings were allocated as a single block
+        pool.release_block(this->children[0]);
+        for(unsigned int i=0; i<4; i++) {
+            this->children[i] = nullptr;
+        }
+    }
+};
+
+/**
+ * @brief       loose quadtree indexing objects with a bounding box
+ *
+ * Every object is stored in exactly one node: the deepest node on the path
+ * of its center whose loose bounds still enclose its bounding box. Because
+ * the loose bounds of a node extend beyond its tight box, objects that
+ * straddle the center lines of a node are still pushed down to the child
+ * holding their center, as long as they are not larger than that allows.
+ * With a looseness of 2, an object fits a node whose width and height are
+ * at least its own. Queries prune on the loose bounds.
+ *
+ * Like QuadTree, a node is split once it holds Capacity objects, after
+ * which the objects that fit a child are moved down; larger objects stay.
+ *
+ * @tparam      T           type of the indexed objects
+ * @tparam      Capacity    number of objects in a leaf before it is split
+ * @tparam      Coord       coordinate type (e.g. float or double)
+ * @tparam      MaxDepth    maximum depth of the tree
+ */
+template <class T, unsigned int Capacity = 4, class Coord = double, unsigned int MaxDepth = 32>
+class LooseQuadTree {
+public:
+    typedef LooseQuadTreeNode<Coord, MaxDepth> Node;
+    typedef LooseQuadTreeObject<T, Coord> Object;
+
+private:
+    static_assert(Capacity > 0, "leaf capacity must be positive");
+
+    static const unsigned int nil = Node::nil;
+
+    /**
+     * @brief       object in the linked list of a node (or in the free list)
+     */
+    class Entry {
+    public:
+        Object obj;
+        unsigned int next;
+    };
+
+    Node* root;
+
+    // owns the memory of all nodes in the tree
+    typename Node::Pool pool;
+
+    Coord looseness;
+
+    std::vector<Entry> entries;
+    unsigned int free_entries;  // first entry of the free list
+    size_t nr_objects;
+
+public:
+    LooseQuadTree() :
+        root(nullptr),
+        looseness(2),
+        free_entries(nil),
+        nr_objects(0) {}
+
+    /**
+     * @param       _cx         center x position of the root
+     * @param       _cy         center y position of the root
+     * @param       _width      width of the root
+     * @param       _height     height of the root
+     * @param       _looseness  factor by which the loose bounds of a node exceed its box (at least 1)
+     */
+    LooseQuadTree(Coord _cx, Coord _cy, Coord _width, Coord _height, Coord _looseness = Coord(2)) :
+        looseness(_looseness),
+        free_entries(nil),
+        nr_objects(0) {
+        if(this->looseness < Coord(1)) {
+            std::cerr << "Looseness of a loose quadtree must be at least 1" << std::endl;
+            this->looseness = Coord(1);
+        }
+        this->create_root(_cx, _cy, _width, _height);
+    }
+
+    /**
+     * @brief       remove all objects from the quadtree
+     *
+     * @param       keep_memory     whether to keep the memory for reuse
+     */
+    void clear(bool keep_memory = true) {
+        if(this->root == nullptr) {
+            return;
+        }
+
+        const Coord cx = this->root->get_cx();
+        const Coord cy = this->root->get_cy();
+        const Coord width = this->root->get_width();
+        const Coord height = this->root->get_height();
+
+        this->entries.clear();
+        this->free_entries = nil;
+        this->nr_objects = 0;
+
+        if(keep_memory) {
+            this->pool.reset();
+        } else {
+            this->pool.release();
+            this->entries.shrink_to_fit();
+        }
+
+        this->create_root(cx, cy, width, height);
+    }
+
+    /**
+     * @brief       add an object
+     *
+     * @param       _obj        pointer to the object
+     * @param       xmin        lower x bound of the object
+     * @param       ymin        lower y bound of the object
+     * @param       xmax        upper x bound of the object
+     * @param       ymax        upper y bound of the object
+     */
+    void add(T* _obj, Coord xmin, Coord ymin, Coord xmax, Coord ymax) {
+        if(this->root == nullptr) {
+            std::cerr << "Cannot add objects to quadtree with NULL root" << std::endl;
+            return;
+        }
+
+        if(xmin > xmax || ymin > ymax) {
+            std::cerr << "Cannot add object with an inverted bounding box" << std::endl;
+            return;
+        }
+
+        if(!this->root->encloses(xmin, ymin, xmax, ymax)) {
+            std::cerr << "Cannot add object outside the loose bounds of the quadtree" << std::endl;
+            return;
+        }
+
+        this->insert(this->root, this->allocate_entry(Object(_obj, xmin, ymin, xmax, ymax)));
+        this->nr_objects++;
+    }
+
+    /**
+     * @brief       remove an object
+     *
+     * @param       _obj        pointer to the object
+     * @param       xmin        lower x bound under which the object was added
+     * @param       ymin        lower y bound under which the object was added
+     * @param       xmax        upper x bound under which the object was added
+     * @param       ymax        upper y bound under which the object was added
+     *
+     * @return      whether the object was found
+     */
+    bool remove(T* _obj, Coord xmin, Coord ymin, Coord xmax, Coord ymax) {
+        Node* node = nullptr;
+        unsigned int prev = nil;
+        const unsigned int idx = this->find(_obj, xmin, ymin, xmax, ymax, node, prev);
+        if(idx == nil) {
+            return false;
+        }
+
+        this->unlink(node, idx, prev);
+        this->release_entry(idx);
+        this->nr_objects--;
+        this->collapse(node->has_children() ? node : node->get_parent());
+
+        return true;
+    }
+
+    /**
+     * @brief       move an object to a new bounding box
+     *
+     * When the new box leads to the node holding the object, only the stored
+     * box is updated. Otherwise the object is relinked to the node on the
+     * path of the new box.
+     *
+     * @return      whether the object was found and moved
+     */
+    bool move(T* _obj, Coord old_xmin, Coord old_ymin, Coord old_xmax, Coord old_ymax,
+              Coord new_xmin, Coord new_ymin, Coord new_xmax, Coord new_ymax) {
+        if(this->root == nullptr) {
+            return false;
+        }
+
+        if(new_xmin > new_xmax || new_ymin > new_ymax || !this->root->encloses(new_xmin, new_ymin, new_xmax, new_ymax)) {
+            std::cerr << "Cannot move object outside the loose bounds of the quadtree" << std::endl;
+            return false;
+        }
+
+        Node* node = nullptr;
+        unsigned int prev = nil;
+        const unsigned int idx = this->find(_obj, old_xmin, old_ymin, old_xmax, old_ymax, node, prev);
+        if(idx == nil) {
+            return false;
+        }
+
+        const Object obj(_obj, new_xmin, new_ymin, new_xmax, new_ymax);
+        Node* target = this->find_node(obj);
+        this->entries[idx].obj = obj;
+        if(target == node) {
+            return true;
+        }
+
+        this->unlink(node, idx, prev);
+        this->insert(target, idx);
+
+        this->collapse(node->has_children() ? node : node->get_parent());
+
+        return true;
+    }
+
+    /**
+     * @brief       find all objects whose bounding box overlaps with a rectangle
+     *
+     * @param       xmin        lower x bound of the rectangle
+     * @param       ymin        lower y bound of the rectangle
+     * @param       xmax        upper x bound of the rectangle
+     * @param       ymax        upper y bound of the rectangle
+     * @param       results     vector to which the objects are appended
+     */
+    void query_overlap(Coord xmin, Coord ymin, Coord xmax, Coord ymax, std::vector<Object>& results) const {
+        if(this->root == nullptr) {
+            return;
+        }
+
+        QuadTreeTraversal<const Node>::pruned(this->root, [=, &results](const Node* node) -> bool {
+            if(!node->overlaps(xmin, ymin, xmax, ymax)) {
+                return false;
+            }
+
+            for(unsigned int i=node->get_first(); i!=nil; i=this->entries[i].next) {
+                const Object& obj = this->entries[i].obj;
+                if(obj.xmin <= xmax && obj.xmax >= xmin && obj.ymin <= ymax && obj.ymax >= ymin) {
+                    results.push_back(obj);
+                }
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       find all objects whose bounding box lies inside a rectangle
+     *
+     * Subtrees whose loose bounds lie fully inside the rectangle are
+     * accepted without testing the individual objects.
+     *
+     * @param       xmin        lower x bound of the rectangle
+     * @param       ymin        lower y bound of the rectangle
+     * @param       xmax        upper x bound of the rectangle
+     * @param       ymax        upper y bound of the rectangle
+     * @param       results     vector to which the objects are appended
+     */
+    void query_range(Coord xmin, Coord ymin, Coord xmax, Coord ymax, std::vector<Object>& results) const {
+        if(this->root == nullptr) {
+            return;
+        }
+
+        QuadTreeTraversal<const Node>::pruned(this->root, [=, &results](const Node* node) -> bool {
+            if(!node->overlaps(xmin, ymin, xmax, ymax)) {
+                return false;
+            }
+
+            if(node->get_loose_xmin() >= xmin && node->get_loose_xmax() <= xmax &&
+               node->get_loose_ymin() >= ymin && node->get_loose_ymax() <= ymax) {
+                this->collect(node, results);
+                return false;
+            }
+
+            for(unsigned int i=node->get_first(); i!=nil; i=this->entries[i].next) {
+                const Object& obj = this->entries[i].obj;
+                if(obj.xmin >= xmin && obj.xmax <= xmax && obj.ymin >= ymin && obj.ymax <= ymax) {
+                    results.push_back(obj);
+                }
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       find all objects whose bounding box contains a position
+     */
+    void query_point(Coord x, Coord y, std::vector<Object>& results) const {
+        this->query_overlap(x, y, x, y, results);
+    }
+
+    /**
+     * @brief       number of objects stored
+     */
+    size_t size() const {
+        return this->nr_objects;
+    }
+
+    /**
+     * @brief       number of bytes allocated for the tree
+     */
+    size_t get_memory_usage() const {
+        return sizeof(*this) + this->pool.get_bytes_reserved() + this->entries.capacity() * sizeof(Entry);
+    }
+
+    const Node* get_root() const {
+        return this->root;
+    }
+
+    void print() const {
+        if(this->root == nullptr) {
+            return;
+        }
+
+        QuadTreeTraversal<const Node>::pre_order(this->root, [this](const Node* node) {
+            std::cout << "NODE: " << node->get_cx() << "\t" << node->get_cy() << "\t" << node->get_level() << std::endl;
+            for(unsigned int i=node->get_first(); i!=nil; i=this->entries[i].next) {
+                const Object& obj = this->entries[i].obj;
+                std::cout << obj.xmin << "\t" << obj.ymin << "\t" << obj.xmax << "\t" << obj.ymax << "\t" << obj.objptr << std::endl;
+            }
+        });
+    }
+
+private:
+    /**
+     * @brief       allocate the root node from the pool
+     */
+    void create_root(Coord cx, Coord cy, Coord width, Coord height) {
+        Node* block = this->pool.allocate_block();
+        this->root = new(block) Node(cx, cy, width, height, this->looseness, 0, nullptr);
+    }
+
+    unsigned int allocate_entry(const Object& obj) {
+        unsigned int idx = this->free_entries;
+        if(idx != nil) {
+            this->free_entries = this->entries[idx].next;
+        } else {
+            idx = this->entries.size();
+            this->entries.push_back(Entry());
+        }
+
+        this->entries[idx].obj = obj;
+        this->entries[idx].next = nil;
+        return idx;
+    }
+
+    void release_entry(unsigned int idx) {
+        this->entries[idx].next = this->free_entries;
+        this->free_entries = idx;
+    }
+
+    inline void link(Node* node, unsigned int idx) {
+        this->entries[idx].next = node->get_first();
+        node->set_first(idx);
+        node->set_nr_objects(node->get_nr_objects() + 1);
+    }
+
+    inline void unlink(Node* node, unsigned int idx, unsigned int prev) {
+        if(prev == nil) {
+            node->set_first(this->entries[idx].next);
+        } else {
+            this->entries[prev].next = this->entries[idx].next;
+        }
+        node->set_nr_objects(node->get_nr_objects() - 1);
+    }
+
+    /**
+     * @brief       get the child of a node into which an object would be pushed down, if any
+     */
+    inline Node* fitting_child(Node* node, const Object& obj) const {
+        if(!node->has_children()) {
+            return nullptr;
+        }
+
+        Node* child = node->get_child(node->quadrant((obj.xmin + obj.xmax) / Coord(2), (obj.ymin + obj.ymax) / Coord(2)));
+        return child->encloses(obj.xmin, obj.ymin, obj.xmax, obj.ymax) ? child : nullptr;
+    }
+
+    /**
+     * @brief       find the deepest existing node on the path of an object
+     */
+    inline Node* find_node(const Object& obj) const {
+        Node* node = this->root;
+        for(Node* child = this->fitting_child(node, obj); child != nullptr; child = this->fitting_child(node, obj)) {
+            node = child;
+        }
+        return node;
+    }
+
+    /**
+     * @brief       store an entry in the subtree below a node whose loose bounds enclose it
+     */
+    void insert(Node* node, unsigned int idx) {
+        const Object& obj = this->entries[idx].obj;
+
+        while(true) {
+            if(!node->has_children()) {
+                if(node->get_nr_objects() < Capacity || node->get_level() >= MaxDepth) {
+                    this->link(node, idx);
+                    return;
+                }
+
+                this->split(node);
+            }
+
+            Node* child = this->fitting_child(node, obj);
+            if(child == nullptr) {
+                this->link(node, idx);
+                return;
+            }
+            node = child;
+        }
+    }
+
+    /**
+     * @brief       split a leaf and push its objects down where they fit
+     */
+    void split(Node* node) {
+        node->split(this->looseness, this->pool);
+
+        unsigned int idx = node->get_first();
+        node->set_first(nil);
+        node->set_nr_objects(0);
+
+        while(idx != nil) {
+            const unsigned int next = this->entries[idx].next;
+            Node* child = this->fitting_child(node, this->entries[idx].obj);
+            this->link(child != nullptr ? child : node, idx);
+            idx = next;
+        }
+    }
+
+    /**
+     * @brief       locate an object by following the path of its bounding box
+     *
+     * @param       node        receives the node holding the object
+     * @param       prev        receives the preceding entry in the list of the node (or nil)
+     *
+     * @return      entry of the object or nil when absent
+     */
+    unsigned int find(T* _obj, Coord xmin, Coord ymin, Coord xmax, Coord ymax, Node*& node, unsigned int& prev) const {
+        if(this->root == nullptr || !this->root->encloses(xmin, ymin, xmax, ymax)) {
+            return nil;
+        }
+
+        const Object obj(_obj, xmin, ymin, xmax, ymax);
+        node = this->root;
+        while(node != nullptr) {
+            prev = nil;
+            for(unsigned int i=node->get_first(); i!=nil; i=this->entries[i].next) {
+                if(this->entries[i].obj.objptr == _obj) {
+                    return i;
+                }
+                prev = i;
+            }
+            node = this->fitting_child(node, obj);
+        }
+
+        return nil;
+    }
+
+    /**
+     * @brief       merge children back into their parent while possible
+     *
+     * Starting at a node and walking up via the parent pointers, the four
+     * children of a node are merged into the node when all of them are
+     * leaves and together with the node hold no more objects than the leaf
+     * capacity.
+     */
+    void collapse(Node* node) {
+        while(node != nullptr && node->has_children()) {
+            size_t count = node->get_nr_objects();
+            for(unsigned int i=0; i<4; i++) {
+                if(node->get_child(i)->has_children()) {
+                    return;
+                }
+                count += node->get_child(i)->get_nr_objects();
+            }
+
+            if(count > Capacity) {
+                return;
+            }
+
+            for(unsigned int i=0; i<4; i++) {
+                Node* child = node->get_child(i);
+                unsigned int idx = child->get_first();
+                while(idx != nil) {
+                    const unsigned int next = this->entries[idx].next;
+                    this->link(node, idx);
+                    idx = next;
+                }
+            }
+
+            node->release_children(this->pool);
+            node = node->get_parent();
+        }
+    }
+
+    /**
+     * @brief       append the objects of a node and its descendants
+     */
+    void collect(const Node* start, std::vector<Object>& results) const {
+        QuadTreeTraversal<const Node>::pre_order(start, [this, &results](const Node* node) {
+            for(unsigned int i=node->get_first(); i!=nil; i=this->entries[i].next) {
+                results.push_back(this->entries[i].obj);
+            }
+        });
+    }
+
+    LooseQuadTree(LooseQuadTree const&)          = delete;
+    void operator=(LooseQuadTree const&)  = delete;
+};
+
+#endif //_LOOSE_QUAD_TREE
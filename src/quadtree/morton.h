@@ -0,0 +1,118 @@
+#ifndef _MORTON_H
+#define _MORTON_H
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+/**
+ * @brief       spread the bits of a 32-bit integer over the even bits of a 64-bit integer
+ */
+inline uint64_t morton_spread(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2))  & 0x3333333333333333ULL;
+    x = (x | (x << 1))  & 0x5555555555555555ULL;
+    return x;
+}
+
+/**
+ * @brief       gather the even bits of a 64-bit integer into a 32-bit integer
+ */
+inline uint32_t morton_compact(uint64_t x) {
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1))  & 0x3333333333333333ULL;
+    x = (x | (x >> 2))  & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4))  & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8))  & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return uint32_t(x);
+}
+
+/**
+ * @brief       interleave two 32-bit grid coordinates into a Morton (Z-order) code
+ *
+ * The x coordinate occupies the even bits and the y coordinate the odd bits,
+ * matching the child order used by QuadTreeNode::quadrant().
+ */
+inline uint64_t morton_encode(uint32_t ix, uint32_t iy) {
+    return morton_spread(ix) | (morton_spread(iy) << 1);
+}
+
+/**
+ * @brief       sort an array of key / value pairs on the upper bits of the key
+ *
+ * Least significant digit radix sort using 8-bit digits. Only the upper
+ * 'bits' bits of the keys are considered; digits on which all keys agree
+ * are skipped. Depending on the number of passes, the sorted pairs end up
+ * in either 'items' or 'buffer'.
+ *
+ * @param       items       key / value pairs to sort
+ * @param       buffer      scratch array of at least 'n' elements
+ * @param       n           number of pairs
+ * @param       bits        number of significant (upper) key bits
+ *
+ * @return      array holding the sorted pairs
+ */
+template <class V>
+std::pair<uint64_t, V>* morton_radix_sort(std::pair<uint64_t, V>* items, std::pair<uint64_t, V>* buffer, size_t n, unsigned int bits) {
+    if(n == 0) {
+        return items;
+    }
+
+    std::pair<uint64_t, V>* src = items;
+    std::pair<uint64_t, V>* dst = buffer;
+
+    const unsigned int nr_passes = (bits + 7) / 8;
+    for(unsigned int pass=0; pass<nr_passes; pass++) {
+        const unsigned int shift = 64 - 8 * nr_passes + 8 * pass;
+
+        size_t counts[256] = {0};
+        for(size_t i=0; i<n; i++) {
+            counts[(src[i].first >> shift) & 0xFF]++;
+        }
+
+        // skip digits on which all keys agree
+        if(counts[(src[0].first >> shift) & 0xFF] == n) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for(unsigned int i=0; i<256; i++) {
+            const size_t count = counts[i];
+            counts[i] = offset;
+            offset += count;
+        }
+
+        for(size_t i=0; i<n; i++) {
+            dst[counts[(src[i].first >> shift) & 0xFF]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    return src;
+}
+
+/**
+ * @brief       sort key / value pairs on the upper bits of the key
+ *
+ * @param       items       key / value pairs to sort
+ * @param       buffer      scratch buffer (resized as needed)
+ * @param       bits        number of significant (upper) key bits
+ */
+template <class V>
+void morton_radix_sort(std::vector<std::pair<uint64_t, V>>& items, std::vector<std::pair<uint64_t, V>>& buffer, unsigned int bits) {
+    if(items.empty()) {
+        return;
+    }
+
+    buffer.resize(items.size(), items[0]);
+    if(morton_radix_sort(items.data(), buffer.data(), items.size(), bits) != items.data()) {
+        items.swap(buffer);
+    }
+}
+
+#endif //_MORTON_H
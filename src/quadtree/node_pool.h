@@ -0,0 +1,247 @@
+#ifndef _NODE_POOL_H
+#define _NODE_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief       arena allocator handing out blocks of four sibling nodes
+ *
+ * Memory is obtained from the heap in chunks of increasing size and carved
+ * into blocks of four contiguous nodes. Released blocks are kept on a free
+ * list for reuse. Single nodes (used for overflow chains) are carved from
+ * blocks as well. Because the nodes are trivially destructible, a whole tree
+ * is discarded by resetting the pool without visiting its nodes; the chunks
+ * are kept for the next build unless they are explicitly released.
+ */
+template <class Node>
+class QuadTreeNodePool {
+private:
+    static_assert(std::is_trivially_destructible<Node>::value, "pooled nodes must be trivially destructible");
+
+    static const size_t min_chunk_blocks = 64;
+    static const size_t max_chunk_blocks = 16384;
+
+    std::vector<std::pair<Node*, size_t>> chunks;   // memory and number of blocks per chunk
+    size_t current_chunk;                           // chunk from which new blocks are carved
+    size_t current_used;                            // blocks used in the current chunk
+    std::vector<Node*> free_blocks;                 // released blocks available for reuse
+    std::vector<Node*> free_nodes;                  // single nodes available for allocate_node()
+    size_t nr_blocks;                               // number of blocks in use
+    size_t nr_node_blocks;                          // number of blocks carved into single nodes
+
+public:
+    QuadTreeNodePool() :
+        current_chunk(0),
+        current_used(0),
+        nr_blocks(0),
+        nr_node_blocks(0) {}
+
+    QuadTreeNodePool(QuadTreeNodePool&& other) :
+        chunks(std::move(other.chunks)),
+        current_chunk(other.current_chunk),
+        current_used(other.current_used),
+        free_blocks(std::move(other.free_blocks)),
+        free_nodes(std::move(other.free_nodes)),
+        nr_blocks(other.nr_blocks),
+        nr_node_blocks(other.nr_node_blocks) {
+        other.chunks.clear();
+        other.free_blocks.clear();
+        other.free_nodes.clear();
+        other.current_chunk = 0;
+        other.current_used = 0;
+        other.nr_blocks = 0;
+        other.nr_node_blocks = 0;
+    }
+
+    QuadTreeNodePool& operator=(QuadTreeNodePool&& other) {
+        if(this != &other) {
+            this->release();
+            this->chunks = std::move(other.chunks);
+            this->current_chunk = other.current_chunk;
+            this->current_used = other.current_used;
+            this->free_blocks = std::move(other.free_blocks);
+            this->free_nodes = std::move(other.free_nodes);
+            this->nr_blocks = other.nr_blocks;
+            this->nr_node_blocks = other.nr_node_blocks;
+            other.chunks.clear();
+            other.free_blocks.clear();
+            other.free_nodes.clear();
+            other.current_chunk = 0;
+            other.current_used = 0;
+            other.nr_blocks = 0;
+            other.nr_node_blocks = 0;
+        }
+        return *this;
+    }
+
+    ~QuadTreeNodePool() {
+        this->release();
+    }
+
+    /**
+     * @brief       obtain uninitialized storage for four contiguous nodes
+     */
+    Node* allocate_block() {
+        this->nr_blocks++;
+        return this->take_block();
+    }
+
+    /**
+     * @brief       return a block obtained from allocate_block() to the pool
+     */
+    void release_block(Node* block) {
+        this->nr_blocks--;
+        this->free_blocks.push_back(block);
+    }
+
+    /**
+     * @brief       obtain uninitialized storage for a single node
+     *
+     * Blocks split up into single nodes are not returned to the block free list.
+     */
+    Node* allocate_node() {
+        if(this->free_nodes.empty()) {
+            Node* block = this->take_block();
+            this->nr_node_blocks++;
+            for(unsigned int i=4; i>0; i--) {
+                this->free_nodes.push_back(block + i - 1);
+            }
+        }
+
+        Node* node = this->free_nodes.back();
+        this->free_nodes.pop_back();
+        return node;
+    }
+
+    /**
+     * @brief       return a node obtained from allocate_node() to the pool
+     */
+    void release_node(Node* node) {
+        this->free_nodes.push_back(node);
+    }
+
+    /**
+     * @brief       take over the memory of another pool, including the nodes allocated from it
+     *
+     * Allows nodes to be allocated from separate pools on different threads
+     * and merged into a single tree afterwards. The chunks of the other pool
+     * are treated as fully used until the next reset().
+     */
+    void adopt(QuadTreeNodePool&& other) {
+        this->chunks.insert(this->chunks.begin() + this->current_chunk, other.chunks.begin(), other.chunks.end());
+        this->current_chunk += other.chunks.size();
+        this->free_blocks.insert(this->free_blocks.end(), other.free_blocks.begin(), other.free_blocks.end());
+        this->free_nodes.insert(this->free_nodes.end(), other.free_nodes.begin(), other.free_nodes.end());
+        this->nr_blocks += other.nr_blocks;
+        this->nr_node_blocks += other.nr_node_blocks;
+
+        other.chunks.clear();
+        other.free_blocks.clear();
+        other.free_nodes.clear();
+        other.current_chunk = 0;
+        other.current_used = 0;
+        other.nr_blocks = 0;
+        other.nr_node_blocks = 0;
+    }
+
+    /**
+     * @brief       mark all blocks as unused while keeping the memory for reuse
+     */
+    void reset() {
+        this->current_chunk = 0;
+        this->current_used = 0;
+        this->free_blocks.clear();
+        this->free_nodes.clear();
+        this->nr_blocks = 0;
+        this->nr_node_blocks = 0;
+    }
+
+    /**
+     * @brief       return all memory to the heap
+     */
+    void release() {
+        for(auto& chunk: this->chunks) {
+            ::operator delete(chunk.first);
+        }
+        this->chunks.clear();
+        this->free_blocks.clear();
+        this->free_blocks.shrink_to_fit();
+        this->free_nodes.clear();
+        this->free_nodes.shrink_to_fit();
+        this->current_chunk = 0;
+        this->current_used = 0;
+        this->nr_blocks = 0;
+        this->nr_node_blocks = 0;
+    }
+
+    /**
+     * @brief       number of blocks currently handed out by allocate_block()
+     */
+    size_t get_nr_blocks() const {
+        return this->nr_blocks;
+    }
+
+    /**
+     * @brief       number of single nodes currently handed out by allocate_node()
+     */
+    size_t get_nr_nodes() const {
+        return 4 * this->nr_node_blocks - this->free_nodes.size();
+    }
+
+    /**
+     * @brief       number of bytes obtained from the heap
+     */
+    size_t get_bytes_reserved() const {
+        size_t bytes = 0;
+        for(const auto& chunk: this->chunks) {
+            bytes += chunk.second * 4 * sizeof(Node);
+        }
+        return bytes;
+    }
+
+private:
+    /**
+     * @brief       obtain a block from the free list or carve a new one from the chunks
+     */
+    Node* take_block() {
+        if(!this->free_blocks.empty()) {
+            Node* block = this->free_blocks.back();
+            this->free_blocks.pop_back();
+            return block;
+        }
+
+        while(this->current_chunk < this->chunks.size() &&
+              this->current_used == this->chunks[this->current_chunk].second) {
+            this->current_chunk++;
+            this->current_used = 0;
+        }
+
+        if(this->current_chunk == this->chunks.size()) {
+            size_t blocks = min_chunk_blocks;
+            if(!this->chunks.empty()) {
+                blocks = std::min(this->chunks.back().second * 2, max_chunk_blocks);
+            }
+            Node* memory = static_cast<Node*>(::operator new(blocks * 4 * sizeof(Node)));
+            this->chunks.push_back(std::make_pair(memory, blocks));
+            this->current_used = 0;
+        }
+
+        return this->chunks[this->current_chunk].first + 4 * this->current_used++;
+    }
+
+    QuadTreeNodePool(QuadTreeNodePool const&)          = delete;
+    void operator=(QuadTreeNodePool const&)  = delete;
+};
+
+template <class Node>
+const size_t QuadTreeNodePool<Node>::min_chunk_blocks;
+
+template <class Node>
+const size_t QuadTreeNodePool<Node>::max_chunk_blocks;
+
+#endif //_NODE_POOL_H
@@ -0,0 +1,301 @@
+#include "point_reader.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+PointReader::PointReader() :
+    format(Format::CSV),
+    chunk_size(0),
+    buffer_begin(0),
+    buffer_end(0),
+    eof(false),
+    done(true),
+    stop(false),
+    failed(false),
+    nr_bytes(0),
+    nr_points(0),
+    nr_skipped(0) {}
+
+PointReader::~PointReader() {
+    this->close();
+}
+
+bool PointReader::open(const std::string& filename, size_t _chunk_size) {
+    this->close();
+
+    this->file.open(filename, std::ios::binary);
+    if(!this->file) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return false;
+    }
+
+    this->format = get_format(filename);
+    this->chunk_size = std::max(size_t(1), _chunk_size);
+    this->buffer.resize(block_size);
+    this->buffer_begin = 0;
+    this->buffer_end = 0;
+    this->eof = false;
+
+    this->ready.clear();
+    this->spare.assign(nr_chunks, PointChunk());
+    this->done = false;
+    this->stop = false;
+    this->failed = false;
+    this->nr_bytes = 0;
+    this->nr_points = 0;
+    this->nr_skipped = 0;
+
+    this->thread = std::thread(&PointReader::run, this);
+    return true;
+}
+
+bool PointReader::read_chunk(PointChunk& chunk) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cv.wait(lock, [this]() {
+        return !this->ready.empty() || this->done;
+    });
+
+    if(this->ready.empty()) {
+        return false;
+    }
+
+    // hand the buffers of the previous chunk back to the reader
+    chunk.clear();
+    this->spare.push_back(std::move(chunk));
+    chunk = std::move(this->ready.front());
+    this->ready.pop_front();
+    this->cv.notify_all();
+
+    return true;
+}
+
+void PointReader::close() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+        this->cv.notify_all();
+    }
+
+    if(this->thread.joinable()) {
+        this->thread.join();
+    }
+
+    if(this->file.is_open()) {
+        this->file.close();
+    }
+}
+
+bool PointReader::has_failed() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->failed;
+}
+
+uint64_t PointReader::get_nr_bytes() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->nr_bytes;
+}
+
+uint64_t PointReader::get_nr_points() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->nr_points;
+}
+
+uint64_t PointReader::get_nr_skipped() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->nr_skipped;
+}
+
+PointReader::Format PointReader::get_format(const std::string& filename) {
+    const size_t dot = filename.find_last_of('.');
+    const std::string ext = (dot == std::string::npos) ? std::string() : filename.substr(dot + 1);
+
+    if(ext == "f32") {
+        return Format::FLOAT32;
+    }
+    if(ext == "f64") {
+        return Format::FLOAT64;
+    }
+    return Format::CSV;
+}
+
+void PointReader::run() {
+    while(true) {
+        PointChunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->cv.wait(lock, [this]() {
+                return !this->spare.empty() || this->stop;
+            });
+            if(this->stop) {
+                break;
+            }
+            chunk = std::move(this->spare.back());
+            this->spare.pop_back();
+        }
+
+        const bool ok = this->fill(chunk);
+        const bool last = !ok || (this->eof && this->buffer_begin == this->buffer_end);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->nr_points += chunk.size();
+        if(chunk.size() != 0) {
+            this->ready.push_back(std::move(chunk));
+        } else {
+            this->spare.push_back(std::move(chunk));
+        }
+        if(!ok) {
+            this->failed = true;
+        }
+        if(last) {
+            break;
+        }
+        this->cv.notify_all();
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->done = true;
+    this->cv.notify_all();
+}
+
+bool PointReader::fill(PointChunk& chunk) {
+    chunk.x.reserve(this->chunk_size);
+    chunk.y.reserve(this->chunk_size);
+
+    size_t nr_skipped_lines = 0;
+
+    while(chunk.size() < this->chunk_size) {
+        if(this->format == Format::CSV) {
+            const char* begin = this->buffer.data() + this->buffer_begin;
+            const char* end = this->buffer.data() + this->buffer_end;
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+
+            if(newline == nullptr) {
+                if(!this->eof) {
+                    if(this->buffer_begin == 0 && this->buffer_end == this->buffer.size()) {
+                        std::cerr << "Line exceeds " << this->buffer.size() << " bytes" << std::endl;
+                        return false;
+                    }
+                    this->refill();
+                    if(this->file.bad()) {
+                        std::cerr << "Error reading point file" << std::endl;
+                        return false;
+                    }
+                    continue;
+                }
+                if(begin == end) {
+                    break;
+                }
+                newline = end;  // last line without a line break
+            }
+
+            double x, y;
+            if(parse_line(begin, newline, x, y)) {
+                chunk.x.push_back(x);
+                chunk.y.push_back(y);
+            } else {
+                nr_skipped_lines++;
+            }
+            this->buffer_begin = std::min(size_t(newline - this->buffer.data()) + 1, this->buffer_end);
+        } else {
+            const size_t record = (this->format == Format::FLOAT32) ? 2 * sizeof(float) : 2 * sizeof(double);
+            if(this->buffer_end - this->buffer_begin < record) {
+                if(this->eof) {
+                    if(this->buffer_begin != this->buffer_end) {
+                        std::cerr << "Ignoring " << this->buffer_end - this->buffer_begin << " trailing bytes of point file" << std::endl;
+                        this->buffer_begin = this->buffer_end;
+                    }
+                    break;
+                }
+                this->refill();
+                if(this->file.bad()) {
+                    std::cerr << "Error reading point file" << std::endl;
+                    return false;
+                }
+                continue;
+            }
+
+            const size_t nr_records = std::min((this->buffer_end - this->buffer_begin) / record, this->chunk_size - chunk.size());
+            const unsigned char* data = reinterpret_cast<const unsigned char*>(this->buffer.data() + this->buffer_begin);
+            for(size_t i=0; i<nr_records; i++, data += record) {
+                // assemble the values byte by byte, independent of the host byte order
+                if(this->format == Format::FLOAT32) {
+                    uint32_t bx = 0, by = 0;
+                    for(unsigned int b=0; b<4; b++) {
+                        bx |= uint32_t(data[b]) << (8 * b);
+                        by |= uint32_t(data[4 + b]) << (8 * b);
+                    }
+                    float fx, fy;
+                    std::memcpy(&fx, &bx, sizeof(float));
+                    std::memcpy(&fy, &by, sizeof(float));
+                    chunk.x.push_back(fx);
+                    chunk.y.push_back(fy);
+                } else {
+                    uint64_t bx = 0, by = 0;
+                    for(unsigned int b=0; b<8; b++) {
+                        bx |= uint64_t(data[b]) << (8 * b);
+                        by |= uint64_t(data[8 + b]) << (8 * b);
+                    }
+                    double dx, dy;
+                    std::memcpy(&dx, &bx, sizeof(double));
+                    std::memcpy(&dy, &by, sizeof(double));
+                    chunk.x.push_back(dx);
+                    chunk.y.push_back(dy);
+                }
+            }
+            this->buffer_begin += nr_records * record;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->nr_skipped += nr_skipped_lines;
+    return true;
+}
+
+size_t PointReader::refill() {
+    const size_t remaining = this->buffer_end - this->buffer_begin;
+    std::memmove(this->buffer.data(), this->buffer.data() + this->buffer_begin, remaining);
+    this->buffer_begin = 0;
+    this->buffer_end = remaining;
+
+    this->file.read(this->buffer.data() + remaining, this->buffer.size() - remaining);
+    const size_t count = this->file.gcount();
+    this->buffer_end += count;
+    if(count == 0 || this->file.eof()) {
+        this->eof = true;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->nr_bytes += count;
+    return count;
+}
+
+bool PointReader::parse_line(const char* begin, const char* end, double& x, double& y) {
+    // copy the line such that strtod stops at its end
+    char line[256];
+    const size_t length = std::min(size_t(end - begin), sizeof(line) - 1);
+    std::memcpy(line, begin, length);
+    line[length] = '\0';
+
+    const char* p = line;
+    while(*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if(*p == '#' || *p == '\0' || *p == '\r') {
+        return false;
+    }
+
+    char* next = nullptr;
+    x = std::strtod(p, &next);
+    if(next == p) {
+        return false;
+    }
+
+    p = next;
+    while(*p == ' ' || *p == '\t' || *p == ',' || *p == ';') {
+        p++;
+    }
+    y = std::strtod(p, &next);
+    return next != p;
+}
@@ -0,0 +1,157 @@
+#ifndef _POINT_READER_H
+#define _POINT_READER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * @brief       block of points read from a file
+ */
+class PointChunk {
+public:
+    std::vector<double> x;
+    std::vector<double> y;
+
+    inline size_t size() const {
+        return this->x.size();
+    }
+
+    inline void clear() {
+        this->x.clear();
+        this->y.clear();
+    }
+};
+
+/**
+ * @brief       streams points from a file, parsing on a background thread
+ *
+ * Supported formats:
+ *  - CSV: one point per line as "x,y"; commas, semicolons, tabs and spaces
+ *    are accepted as separators; empty lines, comments (#) and lines that
+ *    do not start with two numbers (e.g. a header) are skipped
+ *  - raw little-endian pairs of 32-bit floats (extension .f32)
+ *  - raw little-endian pairs of 64-bit doubles (extension .f64)
+ *
+ * The file is read in blocks of fixed size and parsed into chunks of a fixed
+ * number of points. At most a few chunks are kept in memory: the reader
+ * thread waits while the consumer has not taken the parsed chunks yet, so
+ * arbitrarily large files can be streamed with constant memory.
+ */
+class PointReader {
+public:
+    enum class Format {
+        CSV,
+        FLOAT32,
+        FLOAT64
+    };
+
+private:
+    static const size_t block_size = 1 << 20;   // bytes read from the file at once
+    static const size_t nr_chunks = 4;          // chunks in flight between the threads
+
+    std::ifstream file;
+    Format format;
+    size_t chunk_size;
+
+    // read buffer, only accessed by the reader thread
+    std::vector<char> buffer;
+    size_t buffer_begin;
+    size_t buffer_end;
+    bool eof;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<PointChunk> ready;       // parsed chunks waiting for the consumer
+    std::vector<PointChunk> spare;      // empty chunks available to the reader
+    bool done;                          // no more chunks will be produced
+    bool stop;                          // the consumer requests the reader to stop
+    bool failed;
+
+    uint64_t nr_bytes;
+    uint64_t nr_points;
+    uint64_t nr_skipped;                // CSV lines without a point
+
+public:
+    PointReader();
+
+    ~PointReader();
+
+    /**
+     * @brief       open a file and start reading it on a background thread
+     *
+     * @param       filename    path of the file; the format follows from the extension
+     * @param       _chunk_size number of points per chunk
+     *
+     * @return      whether the file could be opened
+     */
+    bool open(const std::string& filename, size_t _chunk_size = 65536);
+
+    /**
+     * @brief       wait for the next chunk of points
+     *
+     * The buffers of the chunk passed in are recycled by the reader.
+     *
+     * @param       chunk       receives the points
+     *
+     * @return      false when all points have been read
+     */
+    bool read_chunk(PointChunk& chunk);
+
+    /**
+     * @brief       stop the background thread and close the file
+     */
+    void close();
+
+    /**
+     * @brief       whether reading stopped on an error
+     */
+    bool has_failed();
+
+    uint64_t get_nr_bytes();
+
+    uint64_t get_nr_points();
+
+    uint64_t get_nr_skipped();
+
+    /**
+     * @brief       determine the format of a file from its extension
+     */
+    static Format get_format(const std::string& filename);
+
+private:
+    /**
+     * @brief       body of the background thread
+     */
+    void run();
+
+    /**
+     * @brief       parse points into a chunk until it is full or the file ends
+     *
+     * @return      false on a read error
+     */
+    bool fill(PointChunk& chunk);
+
+    /**
+     * @brief       move unparsed bytes to the front of the buffer and read the next block
+     *
+     * @return      number of bytes read
+     */
+    size_t refill();
+
+    /**
+     * @brief       parse a CSV line; returns false when it does not hold a point
+     */
+    static bool parse_line(const char* begin, const char* end, double& x, double& y);
+
+    PointReader(PointReader const&)          = delete;
+    void operator=(PointReader const&)  = delete;
+};
+
+#endif //_POINT_READER_H
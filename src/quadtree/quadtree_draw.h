@@ -0,0 +1,75 @@
+#ifndef _QUAD_TREE_DRAW
+#define _QUAD_TREE_DRAW
+
+#include <cmath>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "core/shader.h"
+#include "quadtree/traversal.h"
+
+/**
+ * @brief       OpenGL rendering of a quadtree
+ *
+ * Kept apart from the quadtree itself, such that the index does not depend
+ * on any graphics library. Every node is drawn as a unit square scaled to its
+ * size; the caller binds the vertex array holding that square.
+ *
+ * @tparam      Tree        QuadTree type
+ */
+template <class Tree>
+class QuadTreeDraw {
+public:
+    typedef typename Tree::Node Node;
+    typedef typename Tree::Object Object;
+
+    /**
+     * @brief       draw the bounding boxes and the objects of all nodes
+     *
+     * @param       tree        quadtree to draw
+     * @param       shader      shader with a "color" and an "mvp" uniform
+     */
+    static void draw(const Tree& tree, Shader* shader) {
+        if(tree.get_root() == nullptr) {
+            return;
+        }
+
+        const glm::mat4 projection = Camera::get().get_projection();
+
+        QuadTreeTraversal<const Node>::pre_order(tree.get_root(), [shader, &projection](const Node* node) {
+            QuadTreeDraw::draw_local(node, shader, projection);
+        });
+    }
+
+private:
+    /**
+     * @brief       draw the bounding box and the objects of a node only
+     */
+    static void draw_local(const Node* node, Shader* shader, const glm::mat4& projection) {
+        const float xmin = node->get_cx() - node->get_width() / 2.0;
+        const float ymin = node->get_cy() - node->get_height() / 2.0;
+        float scale = node->get_width() / 1.0f;
+        float angle = atan2(node->get_cy(), node->get_cx());
+        float col1 = cos(angle);
+        float col2 = sin(angle);
+        glm::vec4 color = glm::vec4(col1, col2, 1.0f, 0.1f);
+        glm::mat4 mvp = projection * glm::translate(glm::mat4(1.0f), glm::vec3(xmin, ymin, (float)node->get_level() / 10.0f)) * glm::scale(glm::vec3(scale,scale,1.0));
+        shader->set_uniform("color", &color);
+        shader->set_uniform("mvp", &mvp);
+        glDrawElements(GL_TRIANGLE_FAN, 4, GL_UNSIGNED_INT, 0);
+        color = glm::vec4(col1, col2, 1.0f, 1.0f);
+        mvp = projection * glm::translate(glm::mat4(1.0f), glm::vec3(xmin, ymin, 1.0f)) * glm::scale(glm::vec3(scale,scale,1.0));
+        shader->set_uniform("color", &color);
+        glDrawElements(GL_LINE_LOOP, 4, GL_UNSIGNED_INT, 0);
+
+        for(const Node* chain = node; chain != nullptr; chain = chain->get_overflow()) {
+            for(unsigned int i=0; i<chain->get_nr_objects(); i++) {
+                const Object obj = chain->get_object(i);
+                glm::mat4 mvp = projection * glm::translate(glm::mat4(1.0f), glm::vec3(obj.x, obj.y, 1.0f)) * glm::scale(glm::vec3(0.005f,0.005f,1.0));
+                shader->set_uniform("mvp", &mvp);
+                glDrawElements(GL_TRIANGLE_FAN, 4, GL_UNSIGNED_INT, 0);
+            }
+        }
+    }
+};
+
+#endif //_QUAD_TREE_DRAW
@@ -0,0 +1,601 @@
+#ifndef _QUAD_TREE_FILE
+#define _QUAD_TREE_FILE
+
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "quadtree/traversal.h"
+
+/**
+ * File layout (version 1), in native byte order:
+ *
+ *  - QuadTreeFileHeader
+ *  - nodes     nr_nodes x QuadTreeFileNode<Coord>, in breadth-first order
+ *  - x         nr_objects x Coord
+ *  - y         nr_objects x Coord
+ *  - ids       nr_objects x uint64_t
+ *
+ * Every section starts at a multiple of 8 bytes. The four children of a
+ * node are stored consecutively at a position relative to the node. The
+ * objects are stored in depth-first (Morton) order, such that the objects
+ * of any subtree form a contiguous range of the object arrays.
+ */
+
+static const char quadtree_file_magic[8] = {'Q', 'U', 'A', 'D', 'T', 'R', 'E', 'E'};
+static const uint32_t quadtree_file_version = 1;
+static const uint32_t quadtree_file_byte_order = 0x01020304;
+
+/**
+ * @brief       header of a quadtree file
+ */
+class QuadTreeFileHeader {
+public:
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;    // quadtree_file_byte_order as written by the producer
+    uint32_t coord_size;    // size of a coordinate in bytes
+    uint32_t max_depth;     // maximum level of any node
+    uint64_t nr_nodes;
+    uint64_t nr_objects;
+    uint64_t nodes_offset;  // file offsets of the sections
+    uint64_t x_offset;
+    uint64_t y_offset;
+    uint64_t ids_offset;
+};
+
+/**
+ * @brief       node of a quadtree file
+ *
+ * Offers the interface used by QuadTreeTraversal, such that the nodes can
+ * be traversed directly in the mapped file.
+ *
+ * @tparam      Coord       coordinate type
+ * @tparam      MaxDepth    maximum depth accepted when reading
+ */
+template <class Coord = double, unsigned int MaxDepth = 32>
+class QuadTreeFileNode {
+public:
+    static const unsigned int max_depth = MaxDepth;
+
+    Coord xmin;
+    Coord ymin;
+    Coord xmax;
+    Coord ymax;
+    uint64_t begin;         // first object of the subtree
+    uint64_t count;         // number of objects in the subtree
+    uint32_t child_offset;  // distance (in nodes) to the first child, 0 for leaves
+    uint32_t level;
+
+    inline bool has_children() const {
+        return this->child_offset != 0;
+    }
+
+    inline const QuadTreeFileNode* get_child(unsigned int i) const {
+        return this + this->child_offset + i;
+    }
+};
+
+/**
+ * @brief       object returned by queries on a mapped quadtree
+ */
+template <class Coord = double>
+class QuadTreeFileObject {
+public:
+    QuadTreeFileObject() :
+    id(0),
+    x(0),
+    y(0) {}
+
+    QuadTreeFileObject(uint64_t _id, Coord _x, Coord _y) :
+    id(_id),
+    x(_x),
+    y(_y) {}
+
+    uint64_t id;
+    Coord x;
+    Coord y;
+};
+
+/**
+ * @brief       round a file offset up to a multiple of 8 bytes
+ */
+inline uint64_t quadtree_file_align(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+/**
+ * @brief       write a quadtree to a file
+ *
+ * The objects are stored by their position and an identifier supplied by
+ * the caller, as pointers cannot be persisted.
+ *
+ * @param       tree        tree to store
+ * @param       filename    path of the file
+ * @param       get_id      callable taking an object pointer and returning its uint64_t identifier
+ *
+ * @return      whether the file was written
+ */
+template <class Tree, class IdFunc>
+bool quadtree_save(const Tree& tree, const char* filename, IdFunc get_id) {
+    typedef typename Tree::Node Node;
+    typedef typename Node::coord_type Coord;
+    typedef QuadTreeFileNode<Coord, Node::max_depth> FileNode;
+
+    if(tree.get_root() == nullptr) {
+        std::cerr << "Cannot save quadtree with NULL root" << std::endl;
+        return false;
+    }
+
+    // number the nodes in breadth-first order such that siblings are consecutive
+    std::vector<const Node*> order(1, tree.get_root());
+    std::vector<FileNode> nodes;
+    uint32_t max_level = 0;
+    for(size_t i=0; i<order.size(); i++) {
+        const Node* node = order[i];
+        FileNode fnode;
+        fnode.xmin = node->get_xmin();
+        fnode.ymin = node->get_ymin();
+        fnode.xmax = node->get_xmax();
+        fnode.ymax = node->get_ymax();
+        fnode.begin = 0;
+        fnode.count = node->get_count();
+        fnode.child_offset = 0;
+        fnode.level = node->get_level();
+        max_level = std::max(max_level, fnode.level);
+
+        if(node->has_children()) {
+            if(order.size() - i > 0xFFFFFFFFu) {
+                std::cerr << "Cannot save quadtree: node offset exceeds 32 bits" << std::endl;
+                return false;
+            }
+            fnode.child_offset = uint32_t(order.size() - i);
+            for(unsigned int c=0; c<4; c++) {
+                order.push_back(node->get_child(c));
+            }
+        }
+        nodes.push_back(fnode);
+    }
+
+    // the objects of a subtree start after those of its preceding siblings
+    for(size_t i=0; i<nodes.size(); i++) {
+        if(!nodes[i].has_children()) {
+            continue;
+        }
+        uint64_t begin = nodes[i].begin;
+        for(unsigned int c=0; c<4; c++) {
+            FileNode& child = nodes[i + nodes[i].child_offset + c];
+            child.begin = begin;
+            begin += child.count;
+        }
+    }
+
+    const uint64_t nr_objects = tree.get_root()->get_count();
+    std::vector<Coord> xs(nr_objects);
+    std::vector<Coord> ys(nr_objects);
+    std::vector<uint64_t> ids(nr_objects);
+    for(size_t i=0; i<nodes.size(); i++) {
+        if(nodes[i].has_children()) {
+            continue;
+        }
+        uint64_t j = nodes[i].begin;
+        for(const Node* chain = order[i]; chain != nullptr; chain = chain->get_overflow()) {
+            for(unsigned int k=0; k<chain->get_nr_objects(); k++) {
+                const typename Tree::Object obj = chain->get_object(k);
+                xs[j] = obj.x;
+                ys[j] = obj.y;
+                ids[j] = get_id(obj.objptr);
+                j++;
+            }
+        }
+    }
+
+    QuadTreeFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, quadtree_file_magic, sizeof(header.magic));
+    header.version = quadtree_file_version;
+    header.byte_order = quadtree_file_byte_order;
+    header.coord_size = sizeof(Coord);
+    header.max_depth = max_level;
+    header.nr_nodes = nodes.size();
+    header.nr_objects = nr_objects;
+    header.nodes_offset = quadtree_file_align(sizeof(header));
+    header.x_offset = quadtree_file_align(header.nodes_offset + nodes.size() * sizeof(FileNode));
+    header.y_offset = quadtree_file_align(header.x_offset + nr_objects * sizeof(Coord));
+    header.ids_offset = quadtree_file_align(header.y_offset + nr_objects * sizeof(Coord));
+
+    std::ofstream out(filename, std::ios::binary);
+    if(!out) {
+        std::cerr << "Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    static const char padding[8] = {0};
+    uint64_t position = 0;
+    const auto write_section = [&out, &position](uint64_t offset, const void* data, uint64_t size) {
+        out.write(padding, offset - position);
+        out.write(reinterpret_cast<const char*>(data), size);
+        position = offset + size;
+    };
+
+    write_section(0, &header, sizeof(header));
+    write_section(header.nodes_offset, nodes.data(), nodes.size() * sizeof(FileNode));
+    write_section(header.x_offset, xs.data(), nr_objects * sizeof(Coord));
+    write_section(header.y_offset, ys.data(), nr_objects * sizeof(Coord));
+    write_section(header.ids_offset, ids.data(), nr_objects * sizeof(uint64_t));
+
+    if(!out) {
+        std::cerr << "Error writing " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief       read-only quadtree answering queries from a memory-mapped file
+ *
+ * Opening a file only maps it and checks the header and the bounds of its
+ * sections; nothing is read or converted up front. Queries traverse the
+ * nodes in the mapped pages, such that only the pages actually touched are
+ * loaded from disk.
+ *
+ * The links between the nodes are not checked on opening, as that would
+ * touch the whole node section. Call validate() after opening a file that
+ * was not written by quadtree_save() or may be corrupt; queries on a file
+ * that does not pass validate() may read outside the mapping.
+ *
+ * @tparam      Coord       coordinate type; must match the file
+ * @tparam      MaxDepth    maximum depth of the tree; must not be exceeded by the file
+ */
+template <class Coord = double, unsigned int MaxDepth = 32>
+class MappedQuadTree {
+public:
+    typedef QuadTreeFileNode<Coord, MaxDepth> Node;
+    typedef QuadTreeFileObject<Coord> Object;
+
+private:
+    void* data;
+    size_t data_size;
+
+    const QuadTreeFileHeader* header;
+    const Node* nodes;
+    const Coord* xs;
+    const Coord* ys;
+    const uint64_t* ids;
+
+public:
+    MappedQuadTree() :
+        data(nullptr),
+        data_size(0),
+        header(nullptr),
+        nodes(nullptr),
+        xs(nullptr),
+        ys(nullptr),
+        ids(nullptr) {}
+
+    ~MappedQuadTree() {
+        this->close();
+    }
+
+    /**
+     * @brief       map a quadtree file
+     *
+     * @return      whether the file was mapped and is valid
+     */
+    bool open(const char* filename) {
+        this->close();
+
+        const int fd = ::open(filename, O_RDONLY);
+        if(fd < 0) {
+            std::cerr << "Cannot open " << filename << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(QuadTreeFileHeader)) {
+            std::cerr << "Invalid quadtree file " << filename << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED) {
+            std::cerr << "Cannot map " << filename << std::endl;
+            return false;
+        }
+
+        this->data = mapped;
+        this->data_size = st.st_size;
+
+        if(!this->check_header()) {
+            std::cerr << "Invalid quadtree file " << filename << std::endl;
+            this->close();
+            return false;
+        }
+
+        const char* base = static_cast<const char*>(this->data);
+        this->header = reinterpret_cast<const QuadTreeFileHeader*>(base);
+        this->nodes = reinterpret_cast<const Node*>(base + this->header->nodes_offset);
+        this->xs = reinterpret_cast<const Coord*>(base + this->header->x_offset);
+        this->ys = reinterpret_cast<const Coord*>(base + this->header->y_offset);
+        this->ids = reinterpret_cast<const uint64_t*>(base + this->header->ids_offset);
+
+        return true;
+    }
+
+    /**
+     * @brief       unmap the file
+     */
+    void close() {
+        if(this->data != nullptr) {
+            munmap(this->data, this->data_size);
+        }
+        this->data = nullptr;
+        this->data_size = 0;
+        this->header = nullptr;
+        this->nodes = nullptr;
+        this->xs = nullptr;
+        this->ys = nullptr;
+        this->ids = nullptr;
+    }
+
+    inline bool is_open() const {
+        return this->data != nullptr;
+    }
+
+    /**
+     * @brief       number of objects stored
+     */
+    size_t size() const {
+        return this->header != nullptr ? this->header->nr_objects : 0;
+    }
+
+    const Node* get_root() const {
+        return this->nodes;
+    }
+
+    /**
+     * @brief       find all objects inside an axis-aligned rectangle
+     *
+     * @param       xmin        lower x bound of the rectangle
+     * @param       ymin        lower y bound of the rectangle
+     * @param       xmax        upper x bound of the rectangle
+     * @param       ymax        upper y bound of the rectangle
+     * @param       results     vector to which the objects are appended
+     */
+    void query_range(Coord xmin, Coord ymin, Coord xmax, Coord ymax, std::vector<Object>& results) const {
+        if(this->nodes == nullptr) {
+            return;
+        }
+
+        QuadTreeTraversal<const Node>::pruned(this->nodes, [=, &results](const Node* node) -> bool {
+            if(node->count == 0 ||
+               node->xmin > xmax || node->xmax < xmin || node->ymin > ymax || node->ymax < ymin) {
+                return false;
+            }
+
+            if(node->xmin >= xmin && node->xmax <= xmax && node->ymin >= ymin && node->ymax <= ymax) {
+                this->collect(node, results);
+                return false;
+            }
+
+            if(!node->has_children()) {
+                for(uint64_t i=node->begin; i<node->begin + node->count; i++) {
+                    if(this->xs[i] >= xmin && this->xs[i] <= xmax && this->ys[i] >= ymin && this->ys[i] <= ymax) {
+                        results.push_back(Object(this->ids[i], this->xs[i], this->ys[i]));
+                    }
+                }
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       find all objects within a distance of a position
+     *
+     * @param       x           x position of the center
+     * @param       y           y position of the center
+     * @param       r           radius
+     * @param       results     vector to which the objects are appended
+     */
+    void query_radius(Coord x, Coord y, Coord r, std::vector<Object>& results) const {
+        if(this->nodes == nullptr) {
+            return;
+        }
+
+        const Coord r2 = r * r;
+        QuadTreeTraversal<const Node>::pruned(this->nodes, [=, &results](const Node* node) -> bool {
+            if(node->count == 0) {
+                return false;
+            }
+
+            const Coord dxmin = std::max(std::max(node->xmin - x, x - node->xmax), Coord(0));
+            const Coord dymin = std::max(std::max(node->ymin - y, y - node->ymax), Coord(0));
+            if(dxmin * dxmin + dymin * dymin > r2) {
+                return false;
+            }
+
+            const Coord dxmax = std::max(x - node->xmin, node->xmax - x);
+            const Coord dymax = std::max(y - node->ymin, node->ymax - y);
+            if(dxmax * dxmax + dymax * dymax <= r2) {
+                this->collect(node, results);
+                return false;
+            }
+
+            if(!node->has_children()) {
+                for(uint64_t i=node->begin; i<node->begin + node->count; i++) {
+                    const Coord dx = this->xs[i] - x;
+                    const Coord dy = this->ys[i] - y;
+                    if(dx * dx + dy * dy <= r2) {
+                        results.push_back(Object(this->ids[i], this->xs[i], this->ys[i]));
+                    }
+                }
+            }
+
+            return true;
+        });
+    }
+
+    /**
+     * @brief       count the objects inside an axis-aligned rectangle
+     */
+    size_t count(Coord xmin, Coord ymin, Coord xmax, Coord ymax) const {
+        size_t count = 0;
+        if(this->nodes == nullptr) {
+            return count;
+        }
+
+        QuadTreeTraversal<const Node>::pruned(this->nodes, [=, &count](const Node* node) -> bool {
+            if(node->count == 0 ||
+               node->xmin > xmax || node->xmax < xmin || node->ymin > ymax || node->ymax < ymin) {
+                return false;
+            }
+
+            if(node->xmin >= xmin && node->xmax <= xmax && node->ymin >= ymin && node->ymax <= ymax) {
+                count += node->count;
+                return false;
+            }
+
+            if(!node->has_children()) {
+                for(uint64_t i=node->begin; i<node->begin + node->count; i++) {
+                    count += (this->xs[i] >= xmin) & (this->xs[i] <= xmax) & (this->ys[i] >= ymin) & (this->ys[i] <= ymax);
+                }
+            }
+
+            return true;
+        });
+
+        return count;
+    }
+
+    /**
+     * @brief       check the links, levels and object ranges of all nodes
+     *
+     * The children of a node must lie after it and inside the node section,
+     * one level deeper, and their object ranges must partition that of their
+     * parent, such that queries stay inside the mapping and terminate. This
+     * reads every node, so it is not done by open().
+     *
+     * @return      whether the file is open and its nodes are consistent
+     */
+    bool validate() const {
+        if(this->header == nullptr) {
+            return false;
+        }
+
+        const QuadTreeFileHeader* h = this->header;
+        const Node& root = this->nodes[0];
+        if(root.level != 0 || root.begin != 0 || root.count != h->nr_objects) {
+            std::cerr << "Quadtree file root does not cover all objects" << std::endl;
+            return false;
+        }
+
+        for(uint64_t i=0; i<h->nr_nodes; i++) {
+            const Node& node = this->nodes[i];
+            if(node.level > h->max_depth || node.begin > h->nr_objects || node.count > h->nr_objects - node.begin) {
+                std::cerr << "Quadtree file node " << i << " is out of range" << std::endl;
+                return false;
+            }
+
+            if(!node.has_children()) {
+                continue;
+            }
+
+            if(h->nr_nodes - i < 4 || node.child_offset > h->nr_nodes - i - 4) {
+                std::cerr << "Quadtree file node " << i << " links to children outside the file" << std::endl;
+                return false;
+            }
+
+            uint64_t begin = node.begin;
+            for(unsigned int c=0; c<4; c++) {
+                const Node& child = this->nodes[i + node.child_offset + c];
+                if(child.level != node.level + 1 || child.begin != begin) {
+                    std::cerr << "Quadtree file node " << i << " has inconsistent children" << std::endl;
+                    return false;
+                }
+                begin += child.count;
+            }
+            if(begin != node.begin + node.count) {
+                std::cerr << "Quadtree file node " << i << " has inconsistent children" << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    /**
+     * @brief       append all objects of a subtree, which form a contiguous range
+     */
+    void collect(const Node* node, std::vector<Object>& results) const {
+        for(uint64_t i=node->begin; i<node->begin + node->count; i++) {
+            results.push_back(Object(this->ids[i], this->xs[i], this->ys[i]));
+        }
+    }
+
+    /**
+     * @brief       check the header and the bounds of all sections of the mapped file
+     */
+    bool check_header() const {
+        const QuadTreeFileHeader* h = static_cast<const QuadTreeFileHeader*>(this->data);
+
+        if(std::memcmp(h->magic, quadtree_file_magic, sizeof(h->magic)) != 0) {
+            return false;
+        }
+
+        if(h->version != quadtree_file_version) {
+            std::cerr << "Unsupported quadtree file version " << h->version << std::endl;
+            return false;
+        }
+
+        if(h->byte_order != quadtree_file_byte_order) {
+            std::cerr << "Quadtree file was written with a different byte order" << std::endl;
+            return false;
+        }
+
+        if(h->coord_size != sizeof(Coord)) {
+            std::cerr << "Quadtree file stores " << h->coord_size << "-byte coordinates, expected " << sizeof(Coord) << std::endl;
+            return false;
+        }
+
+        if(h->max_depth > MaxDepth) {
+            std::cerr << "Quadtree file is deeper than " << MaxDepth << " levels" << std::endl;
+            return false;
+        }
+
+        if(h->nr_nodes == 0) {
+            return false;
+        }
+
+        const auto fits = [this](uint64_t offset, uint64_t count, uint64_t size) {
+            return offset % 8 == 0 && offset <= this->data_size && count <= (this->data_size - offset) / size;
+        };
+
+        if(!fits(h->nodes_offset, h->nr_nodes, sizeof(Node)) ||
+           !fits(h->x_offset, h->nr_objects, sizeof(Coord)) ||
+           !fits(h->y_offset, h->nr_objects, sizeof(Coord)) ||
+           !fits(h->ids_offset, h->nr_objects, sizeof(uint64_t))) {
+            return false;
+        }
+
+        return true;
+    }
+
+    MappedQuadTree(MappedQuadTree const&)          = delete;
+    void operator=(MappedQuadTree const&)  = delete;
+};
+
+#endif //_QUAD_TREE_FILE
@@ -0,0 +1,71 @@
+#ifndef _QUAD_TREE_STATISTICS
+#define _QUAD_TREE_STATISTICS
+
+#include <vector>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * @brief       shape and memory use of a quadtree
+ *
+ * Overflow nodes (chained below leaves at the maximum depth) are counted in
+ * nr_nodes but are not leaves themselves; the objects in their chain count
+ * towards the occupancy of the leaf they hang from.
+ */
+class QuadTreeStatistics {
+public:
+    QuadTreeStatistics() :
+    nr_objects(0),
+    nr_nodes(0),
+    nr_leaves(0),
+    nr_empty_leaves(0),
+    nr_overflow_nodes(0),
+    depth(0),
+    bytes_used(0),
+    bytes_reserved(0) {}
+
+    size_t nr_objects;
+    size_t nr_nodes;                        // all nodes, including overflow nodes
+    size_t nr_leaves;
+    size_t nr_empty_leaves;
+    size_t nr_overflow_nodes;
+    unsigned int depth;                     // level of the deepest leaf
+    size_t bytes_used;                      // memory of the nodes in use
+    size_t bytes_reserved;                  // memory obtained from the heap
+
+    std::vector<size_t> leaves_per_level;   // number of leaves at every level
+    std::vector<size_t> leaf_occupancy;     // number of leaves holding 0, 1, ..., Capacity objects;
+                                            // the last entry counts the leaves with an overflow chain
+
+    /**
+     * @brief       fraction of the leaves that hold no objects
+     */
+    double get_empty_leaf_ratio() const {
+        return this->nr_leaves == 0 ? 0.0 : double(this->nr_empty_leaves) / double(this->nr_leaves);
+    }
+
+    /**
+     * @brief       write a summary including the histograms
+     */
+    void print(std::ostream& out) const {
+        out << "objects:        " << this->nr_objects << std::endl
+            << "nodes:          " << this->nr_nodes << " (" << this->nr_overflow_nodes << " overflow)" << std::endl
+            << "leaves:         " << this->nr_leaves << " (" << this->get_empty_leaf_ratio() * 100.0 << "% empty)" << std::endl
+            << "depth:          " << this->depth << std::endl
+            << "memory:         " << this->bytes_used << " bytes used, " << this->bytes_reserved << " bytes reserved" << std::endl;
+
+        out << "leaves per level:";
+        for(size_t i=0; i<this->leaves_per_level.size(); i++) {
+            out << " " << i << ":" << this->leaves_per_level[i];
+        }
+        out << std::endl;
+
+        out << "leaf occupancy: ";
+        for(size_t i=0; i<this->leaf_occupancy.size(); i++) {
+            out << " " << i << (i + 1 == this->leaf_occupancy.size() ? "+" : "") << ":" << this->leaf_occupancy[i];
+        }
+        out << std::endl;
+    }
+};
+
+#endif //_QUAD_TREE_STATISTICS
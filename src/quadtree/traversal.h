@@ -0,0 +1,189 @@
+#ifndef _QUAD_TREE_TRAVERSAL
+#define _QUAD_TREE_TRAVERSAL
+
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief       non-recursive depth-first traversal of a quadtree
+ *
+ * The traversals keep their state in a stack of fixed size on the call
+ * stack. Because no node is split beyond the depth limit of the tree, the
+ * size of this stack follows from that limit, such that arbitrarily deep
+ * trees can be traversed without recursion or heap allocation.
+ *
+ * Children are visited in the order given by QuadTreeNode::quadrant().
+ *
+ * @tparam      Node        node type, optionally const qualified
+ */
+template <class Node>
+class QuadTreeTraversal {
+public:
+    typedef typename std::remove_const<Node>::type node_type;
+
+    // while a node at level l is expanded, the stack holds at most three
+    // unvisited siblings for every level above it plus its four children
+    static const unsigned int stack_size = 3 * node_type::max_depth + 4;
+
+    /**
+     * @brief       visit nodes top-down, skipping the subtrees of rejected nodes
+     *
+     * @param       root        node at which to start
+     * @param       visit       callable taking a node pointer and returning
+     *                          whether the children of the node should be visited
+     */
+    template <class Visitor>
+    static void pruned(Node* root, Visitor visit) {
+        Node* stack[stack_size];
+        unsigned int top = 0;
+        stack[top++] = root;
+
+        while(top != 0) {
+            Node* node = stack[--top];
+            if(!visit(node) || !node->has_children()) {
+                continue;
+            }
+
+            for(unsigned int i=4; i>0; i--) {
+                stack[top++] = node->get_child(i-1);
+            }
+        }
+    }
+
+    /**
+     * @brief       visit every node before its children
+     *
+     * @param       root        node at which to start
+     * @param       visit       callable taking a node pointer
+     */
+    template <class Visitor>
+    static void pre_order(Node* root, Visitor visit) {
+        QuadTreeTraversal::pruned(root, [&visit](Node* node) -> bool {
+            visit(node);
+            return true;
+        });
+    }
+
+    /**
+     * @brief       visit every node after its children
+     *
+     * @param       root        node at which to start
+     * @param       visit       callable taking a node pointer
+     */
+    template <class Visitor>
+    static void post_order(Node* root, Visitor visit) {
+        struct Frame {
+            Node* node;
+            unsigned int next;  // next child to descend into
+        };
+
+        Frame stack[node_type::max_depth + 1];
+        unsigned int top = 0;
+        stack[top++] = Frame{root, 0};
+
+        while(top != 0) {
+            Frame& frame = stack[top-1];
+            if(frame.node->has_children() && frame.next < 4) {
+                Node* child = frame.node->get_child(frame.next++);
+                stack[top++] = Frame{child, 0};
+                continue;
+            }
+
+            visit(frame.node);
+            top--;
+        }
+    }
+
+    /**
+     * @brief       visit the unordered pairs of nodes of a tree top-down
+     *
+     * Starting from the pair (a, b), which is either a node paired with
+     * itself or two disjoint nodes, the pairs are refined until both nodes
+     * are leaves. A node paired with itself expands into the ten unordered
+     * pairs of its children (including every child paired with itself); a
+     * pair of distinct nodes expands by splitting the larger node. Every
+     * unordered pair of leaves below (a, b) is visited exactly once.
+     *
+     * @param       a           first node
+     * @param       b           second node (may equal a)
+     * @param       visit       callable taking two node pointers and returning
+     *                          whether the pair should be refined
+     */
+    template <class Visitor>
+    static void self_pairs(Node* a, Node* b, Visitor visit) {
+        // every refinement replaces a pair by at most ten pairs and raises the
+        // sum of the levels of the two nodes by at least one
+        std::pair<Node*, Node*> stack[18 * node_type::max_depth + 1];
+        unsigned int top = 0;
+        stack[top++] = std::make_pair(a, b);
+
+        while(top != 0) {
+            const std::pair<Node*, Node*> pair = stack[--top];
+            if(!visit(pair.first, pair.second)) {
+                continue;
+            }
+
+            if(pair.first == pair.second) {
+                if(!pair.first->has_children()) {
+                    continue;
+                }
+                for(unsigned int i=4; i>0; i--) {
+                    for(unsigned int j=4; j>=i; j--) {
+                        stack[top++] = std::make_pair(pair.first->get_child(i-1), pair.first->get_child(j-1));
+                    }
+                }
+                continue;
+            }
+
+            QuadTreeTraversal::refine(pair.first, pair.second, stack, top);
+        }
+    }
+
+    /**
+     * @brief       visit pairs of nodes of two trees top-down
+     *
+     * Starting from the pair (a, b), a pair is refined by splitting the
+     * larger of its two nodes, until both nodes are leaves.
+     *
+     * @param       a           node of the first tree
+     * @param       b           node of the second tree
+     * @param       visit       callable taking two node pointers and returning
+     *                          whether the pair should be refined
+     */
+    template <class Other, class Visitor>
+    static void dual(Node* a, Other* b, Visitor visit) {
+        typedef typename std::remove_const<Other>::type other_type;
+
+        std::pair<Node*, Other*> stack[3 * (node_type::max_depth + other_type::max_depth) + 1];
+        unsigned int top = 0;
+        stack[top++] = std::make_pair(a, b);
+
+        while(top != 0) {
+            const std::pair<Node*, Other*> pair = stack[--top];
+            if(visit(pair.first, pair.second)) {
+                QuadTreeTraversal::refine(pair.first, pair.second, stack, top);
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief       push the children of the larger node of a pair, paired with the other node
+     */
+    template <class Other>
+    static void refine(Node* a, Other* b, std::pair<Node*, Other*>* stack, unsigned int& top) {
+        const bool split_a = a->has_children() &&
+                             (!b->has_children() || a->get_width() + a->get_height() >= b->get_width() + b->get_height());
+        if(split_a) {
+            for(unsigned int i=4; i>0; i--) {
+                stack[top++] = std::make_pair(a->get_child(i-1), b);
+            }
+        } else if(b->has_children()) {
+            for(unsigned int i=4; i>0; i--) {
+                stack[top++] = std::make_pair(a, b->get_child(i-1));
+            }
+        }
+    }
+};
+
+#endif //_QUAD_TREE_TRAVERSAL